@@ -0,0 +1,171 @@
+// EEPROM programmed at boot to drop alias of nodes no longer paired
+#include <bench.h>
+#include <usb_talk.h>
+#include <eeprom.h>
+
+#define ALIAS_BOOT_COUNT 32
+
+static uint8_t _alias_boot_image[BENCH_EEPROM_SIZE];
+
+static int _alias_boot_stale;
+
+static uint64_t _alias_boot_id(int i)
+{
+    return 0x836d19820000 + i;
+}
+
+static bool _alias_boot_is_peer_device(uint64_t id)
+{
+    return id >= _alias_boot_id(_alias_boot_stale);
+}
+
+static bool _alias_boot_is_any_device(uint64_t id)
+{
+    return true;
+}
+
+static int _alias_boot_resolved(void)
+{
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+
+    int resolved = 0;
+
+    for (int i = 0; i < ALIAS_BOOT_COUNT; i++)
+    {
+        uint64_t id;
+
+        int length = snprintf(name, sizeof(name), "kitchen-sensor-%d", i);
+
+        if (eeprom_alias_resolve(name, length, &id))
+        {
+            resolved++;
+        }
+    }
+
+    return resolved;
+}
+
+static void _alias_boot_print(const char *name, int stale)
+{
+    bench_eeprom_counters_t c = bench_eeprom_counters;
+
+    // Boot again without changes to check what was left
+    bench_is_peer_device = _alias_boot_is_any_device;
+
+    eeprom_init();
+
+    printf("alias-boot %-14s %2d stale  %3" PRIu32 " writes %5" PRIu32 " bytes %4" PRIu32 " words %6.1f ms  %s\n", name, stale,
+           c.write_calls, c.write_bytes, c.write_words, (double) c.write_words * BENCH_EEPROM_WORD_PROGRAM_US / 1000.,
+           _alias_boot_resolved() == ALIAS_BOOT_COUNT - stale ? "ok" : "WRONG");
+}
+
+static void _alias_boot_image_new(void)
+{
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+
+    memset(bench_eeprom(), 0, BENCH_EEPROM_SIZE);
+
+    bench_is_peer_device = _alias_boot_is_any_device;
+
+    eeprom_init();
+
+    for (int i = 0; i < ALIAS_BOOT_COUNT; i++)
+    {
+        uint64_t id = _alias_boot_id(i);
+
+        snprintf(name, sizeof(name), "kitchen-sensor-%d", i);
+
+        eeprom_alias_add(&id, name);
+    }
+}
+
+static void _alias_boot_image_legacy(void)
+{
+    uint8_t *eeprom = bench_eeprom();
+
+    memset(eeprom, 0, BENCH_EEPROM_SIZE);
+
+    // Row table of older firmware, count and its complement, then ID and name per row
+    eeprom[EEPROM_ALIAS_ADDRESS_LENGTH] = ALIAS_BOOT_COUNT;
+    eeprom[EEPROM_ALIAS_ADDRESS_LENGTH + 1] = ~ALIAS_BOOT_COUNT;
+
+    for (int i = 0; i < ALIAS_BOOT_COUNT; i++)
+    {
+        uint8_t *row = eeprom + EEPROM_ALIAS_ADDRESS_START + (i * EEPROM_ALIAS_ROW_LENGTH);
+
+        uint64_t id = _alias_boot_id(i);
+
+        memcpy(row, &id, sizeof(id));
+
+        snprintf((char *) row + sizeof(id), EEPROM_ALIAS_NAME_LENGTH, "kitchen-sensor-%d", i);
+    }
+}
+
+static void _alias_boot_run(const char *image, int stale)
+{
+    char name[16];
+
+    _alias_boot_stale = stale;
+
+    // Boot with every node known, then a remove record per stale row, what boot did before
+    memcpy(bench_eeprom(), _alias_boot_image, BENCH_EEPROM_SIZE);
+
+    bench_is_peer_device = _alias_boot_is_any_device;
+
+    bench_eeprom_counters_reset();
+
+    eeprom_init();
+
+    for (int i = 0; i < stale; i++)
+    {
+        uint64_t id = _alias_boot_id(i);
+
+        eeprom_alias_remove(&id);
+    }
+
+    snprintf(name, sizeof(name), "%s/per-row", image);
+
+    _alias_boot_print(name, stale);
+
+    // The same image booted with the stale nodes unpaired
+    memcpy(bench_eeprom(), _alias_boot_image, BENCH_EEPROM_SIZE);
+
+    bench_is_peer_device = _alias_boot_is_peer_device;
+
+    bench_eeprom_counters_reset();
+
+    eeprom_init();
+
+    snprintf(name, sizeof(name), "%s/boot", image);
+
+    _alias_boot_print(name, stale);
+}
+
+int main(void)
+{
+    static const int stales[] = { 0, 1, 8, 16, 24, 32 };
+
+    usb_talk_init();
+
+    // Store as a gateway has it after a while, the same image for every run
+    _alias_boot_image_new();
+
+    memcpy(_alias_boot_image, bench_eeprom(), BENCH_EEPROM_SIZE);
+
+    for (size_t k = 0; k < sizeof(stales) / sizeof(stales[0]); k++)
+    {
+        _alias_boot_run("log", stales[k]);
+    }
+
+    // First boot after an update from the row table
+    _alias_boot_image_legacy();
+
+    memcpy(_alias_boot_image, bench_eeprom(), BENCH_EEPROM_SIZE);
+
+    for (size_t k = 0; k < sizeof(stales) / sizeof(stales[0]); k++)
+    {
+        _alias_boot_run("legacy", stales[k]);
+    }
+
+    return 0;
+}
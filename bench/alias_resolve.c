@@ -0,0 +1,87 @@
+// EEPROM read back per alias name lookup as the store grows
+#include <bench.h>
+#include <usb_talk.h>
+#include <eeprom.h>
+
+#define ALIAS_RESOLVE_ROUNDS 100
+
+static void _alias_resolve_run(int count)
+{
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+
+    // Blank part each run, as on a new gateway
+    memset(bench_eeprom(), 0, BENCH_EEPROM_SIZE);
+
+    eeprom_init();
+
+    for (int i = 0; i < count; i++)
+    {
+        uint64_t id = 0x836d19820000 + i;
+
+        snprintf(name, sizeof(name), "kitchen-sensor-%d", i);
+
+        eeprom_alias_add(&id, name);
+    }
+
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+    bench_eeprom_counters_reset();
+
+    for (int r = 0; r < ALIAS_RESOLVE_ROUNDS; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t id;
+
+            int length = snprintf(name, sizeof(name), "kitchen-sensor-%d", i);
+
+            if (eeprom_alias_resolve(name, length, &id) && (id == 0x836d19820000 + (uint64_t) i))
+            {
+                hits++;
+            }
+        }
+    }
+
+    bench_eeprom_counters_t hit = bench_eeprom_counters;
+
+    bench_eeprom_counters_reset();
+
+    for (int r = 0; r < ALIAS_RESOLVE_ROUNDS; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t id;
+
+            int length = snprintf(name, sizeof(name), "bedroom-sensor-%d", i);
+
+            if (!eeprom_alias_resolve(name, length, &id))
+            {
+                misses++;
+            }
+        }
+    }
+
+    bench_eeprom_counters_t miss = bench_eeprom_counters;
+
+    uint32_t lookups = count * ALIAS_RESOLVE_ROUNDS;
+
+    printf("alias-resolve %2d aliases  hit %5.1f bytes %4.2f reads  miss %5.1f bytes %4.2f reads  %s\n", count,
+           (double) hit.read_bytes / lookups, (double) hit.read_calls / lookups,
+           (double) miss.read_bytes / lookups, (double) miss.read_calls / lookups,
+           ((hits == lookups) && (misses == lookups)) ? "ok" : "WRONG");
+}
+
+int main(void)
+{
+    static const int counts[] = { 1, 8, 16, 32, 64 };
+
+    usb_talk_init();
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        _alias_resolve_run(counts[i]);
+    }
+
+    return 0;
+}
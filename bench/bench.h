@@ -0,0 +1,44 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <twr_common.h>
+#include <bcl.h>
+
+// Data EEPROM of the STM32L083 and the time to program one 32 bit word of it, datasheet t_prog
+#define BENCH_EEPROM_SIZE 6144
+#define BENCH_EEPROM_WORD_PROGRAM_US 3200
+
+typedef struct
+{
+    uint32_t read_calls;
+    uint32_t read_bytes;
+    uint32_t write_calls;
+    uint32_t write_bytes;
+    // Words with at least one changed byte, what the part really programs
+    uint32_t write_words;
+
+} bench_eeprom_counters_t;
+
+extern twr_tick_t bench_tick;
+
+extern bench_eeprom_counters_t bench_eeprom_counters;
+
+// Lines sent to the host
+extern uint32_t bench_uart_lines;
+
+// Peer table of the radio, every node is known by default
+extern bool (*bench_is_peer_device)(uint64_t id);
+
+// Lux meters registered with the SDK, all four addresses of sensors_init_all, and the value they measure
+#define BENCH_LUX_METER_COUNT 4
+
+extern void (*bench_lux_meter_handler)(twr_tag_lux_meter_t *, twr_tag_lux_meter_event_t, void *);
+extern void *bench_lux_meter_param[BENCH_LUX_METER_COUNT];
+extern int bench_lux_meter_count;
+extern float bench_lux;
+
+uint8_t *bench_eeprom(void);
+
+void bench_eeprom_counters_reset(void);
+
+#endif // _BENCH_H
@@ -0,0 +1,89 @@
+// Lines a noisy lux meter sends in 20 minutes, old change-or-timeout check against the filter stage
+#include <bench.h>
+#include <usb_talk.h>
+#include <config.h>
+#include <sensors.h>
+
+#define LUX_FILTER_SECONDS (20 * 60)
+
+static uint32_t _lux_filter_random_state;
+
+static float _lux_filter_random(void)
+{
+    // Fixed generator, the same samples on every host
+    _lux_filter_random_state = _lux_filter_random_state * 1103515245u + 12345u;
+
+    return (float) ((_lux_filter_random_state >> 16) & 0x7fff) / 32768.f - 0.5f;
+}
+
+static uint32_t _lux_filter_run(const char *name)
+{
+    static int runs;
+
+    // Another lux meter each run, so no filter state carries over
+    void *param = bench_lux_meter_param[runs++];
+
+    _lux_filter_random_state = 7;
+
+    uint32_t lines = bench_uart_lines;
+
+    for (int t = 1; t <= LUX_FILTER_SECONDS; t++)
+    {
+        bench_tick = (twr_tick_t) t * 1000;
+
+        // About 8 lx of noise on a step from 500 to 800 lx at 10 min and a 2 lx/s ramp from 15 min
+        float noise = 0.f;
+
+        for (int k = 0; k < 4; k++)
+        {
+            noise += _lux_filter_random();
+        }
+
+        bench_lux = (t < 600 ? 500.f : 800.f) + (noise * 8.f);
+
+        if (t >= 900)
+        {
+            bench_lux = 800.f + ((t - 900) * 2.f) + (noise * 8.f);
+        }
+
+        bench_lux_meter_handler(NULL, TWR_TAG_LUX_METER_EVENT_UPDATE, param);
+    }
+
+    lines = bench_uart_lines - lines;
+
+    printf("lux-filter %-28s %4" PRIu32 " lines\n", name, lines);
+
+    return lines;
+}
+
+int main(void)
+{
+    uint64_t my_device_address = 0x836d19821bb4;
+
+    usb_talk_init();
+
+    config_init();
+
+    sensors_init_all(&my_device_address);
+
+    // Without smoothing, hysteresis, rate and minimum interval the stage is the old check
+    config_set_float(CONFIG_KEY_LUX_METER_SMOOTHING, 1.f);
+    config_set_float(CONFIG_KEY_LUX_METER_HYSTERESIS, 0.f);
+    config_set_float(CONFIG_KEY_LUX_METER_RATE, 0.f);
+    config_set_int(CONFIG_KEY_LUX_METER_MIN_INTERVAL, 0);
+
+    _lux_filter_run("change-or-timeout");
+
+    config_set_float(CONFIG_KEY_LUX_METER_SMOOTHING, LUX_METER_TAG_PUB_SMOOTHING);
+    config_set_float(CONFIG_KEY_LUX_METER_HYSTERESIS, SENSORS_PUB_HYSTERESIS);
+    config_set_float(CONFIG_KEY_LUX_METER_RATE, SENSORS_PUB_RATE);
+    config_set_int(CONFIG_KEY_LUX_METER_MIN_INTERVAL, LUX_METER_TAG_PUB_MIN_INTERVAL);
+
+    _lux_filter_run("filter-stage-defaults");
+
+    config_set_float(CONFIG_KEY_LUX_METER_RATE, 20.f);
+
+    _lux_filter_run("filter-stage-rate-20");
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <bench.h>
+
+twr_tick_t bench_tick;
+
+bench_eeprom_counters_t bench_eeprom_counters;
+
+uint32_t bench_uart_lines;
+
+static bool _bench_is_peer_device(uint64_t id);
+
+bool (*bench_is_peer_device)(uint64_t id) = _bench_is_peer_device;
+
+void (*bench_lux_meter_handler)(twr_tag_lux_meter_t *, twr_tag_lux_meter_event_t, void *);
+void *bench_lux_meter_param[BENCH_LUX_METER_COUNT];
+int bench_lux_meter_count;
+float bench_lux;
+
+// Stack painting in stats.c takes the end of bss from the linker script
+uint32_t _ebss;
+uint32_t _estack;
+
+static uint8_t _bench_eeprom[BENCH_EEPROM_SIZE];
+
+uint8_t *bench_eeprom(void)
+{
+    return _bench_eeprom;
+}
+
+void bench_eeprom_counters_reset(void)
+{
+    memset(&bench_eeprom_counters, 0, sizeof(bench_eeprom_counters));
+}
+
+bool twr_eeprom_write(uint32_t address, const void *buffer, size_t length)
+{
+    if (address + length > sizeof(_bench_eeprom))
+    {
+        return false;
+    }
+
+    const uint8_t *data = buffer;
+
+    uint32_t last_word = UINT32_MAX;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if ((_bench_eeprom[address + i] != data[i]) && ((address + i) / 4 != last_word))
+        {
+            last_word = (address + i) / 4;
+
+            bench_eeprom_counters.write_words++;
+        }
+
+        _bench_eeprom[address + i] = data[i];
+    }
+
+    bench_eeprom_counters.write_calls++;
+    bench_eeprom_counters.write_bytes += length;
+
+    return true;
+}
+
+bool twr_eeprom_read(uint32_t address, void *buffer, size_t length)
+{
+    if (address + length > sizeof(_bench_eeprom))
+    {
+        return false;
+    }
+
+    memcpy(buffer, _bench_eeprom + address, length);
+
+    bench_eeprom_counters.read_calls++;
+    bench_eeprom_counters.read_bytes += length;
+
+    return true;
+}
+
+size_t twr_eeprom_get_size(void)
+{
+    return sizeof(_bench_eeprom);
+}
+
+twr_tick_t twr_tick_get(void)
+{
+    return bench_tick;
+}
+
+twr_scheduler_task_id_t twr_scheduler_register(void (*task)(void *), void *param, twr_tick_t tick)
+{
+    static twr_scheduler_task_id_t task_id;
+
+    (void) task;
+    (void) param;
+    (void) tick;
+
+    return task_id++;
+}
+
+void twr_scheduler_plan_current_now(void) {}
+void twr_scheduler_plan_current_relative(twr_tick_t tick) { (void) tick; }
+void twr_scheduler_plan_current_absolute(twr_tick_t tick) { (void) tick; }
+void twr_scheduler_plan_now(twr_scheduler_task_id_t task_id) { (void) task_id; }
+void twr_scheduler_plan_relative(twr_scheduler_task_id_t task_id, twr_tick_t tick) { (void) task_id; (void) tick; }
+void twr_scheduler_plan_absolute(twr_scheduler_task_id_t task_id, twr_tick_t tick) { (void) task_id; (void) tick; }
+
+twr_tick_t twr_scheduler_get_spin_tick(void)
+{
+    return bench_tick;
+}
+
+twr_scheduler_task_id_t twr_scheduler_get_current_task_id(void)
+{
+    return 0;
+}
+
+void twr_timer_init(void) {}
+void twr_timer_start(void) {}
+
+uint16_t twr_timer_get_microseconds(void)
+{
+    return 0;
+}
+
+void twr_fifo_init(twr_fifo_t *fifo, void *buffer, size_t size)
+{
+    fifo->buffer = buffer;
+    fifo->size = size;
+    fifo->head = 0;
+    fifo->tail = 0;
+}
+
+static void _bench_count_lines(const void *buffer, size_t length)
+{
+    const char *data = buffer;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (data[i] == '\n')
+        {
+            bench_uart_lines++;
+        }
+    }
+}
+
+void twr_uart_init(twr_uart_channel_t channel, int baudrate, int setting) { (void) channel; (void) baudrate; (void) setting; }
+void twr_uart_set_async_fifo(twr_uart_channel_t channel, twr_fifo_t *write_fifo, twr_fifo_t *read_fifo) { (void) channel; (void) write_fifo; (void) read_fifo; }
+
+size_t twr_uart_async_write(twr_uart_channel_t channel, const void *buffer, size_t length)
+{
+    (void) channel;
+
+    _bench_count_lines(buffer, length);
+
+    return length;
+}
+
+size_t twr_uart_async_read(twr_uart_channel_t channel, void *buffer, size_t length) { (void) channel; (void) buffer; (void) length; return 0; }
+bool twr_uart_async_read_start(twr_uart_channel_t channel, twr_tick_t timeout) { (void) channel; (void) timeout; return true; }
+void twr_uart_set_event_handler(twr_uart_channel_t channel, void (*event_handler)(twr_uart_channel_t, twr_uart_event_t, void *), void *event_param) { (void) channel; (void) event_handler; (void) event_param; }
+
+void twr_usb_cdc_init(void) {}
+
+bool twr_usb_cdc_write(const void *buffer, size_t length)
+{
+    _bench_count_lines(buffer, length);
+
+    return true;
+}
+
+size_t twr_usb_cdc_read(void *buffer, size_t length) { (void) buffer; (void) length; return 0; }
+
+// Only buffer output uses base64, the benchmarks send none
+size_t twr_base64_calculate_encode_length(size_t length) { return 4 * ((length + 2) / 3); }
+size_t twr_base64_calculate_decode_length(char *input, size_t length) { (void) input; return length / 4 * 3; }
+bool twr_base64_encode(char *output, size_t *output_length, const uint8_t *input, size_t input_length) { (void) output; (void) output_length; (void) input; (void) input_length; return false; }
+bool twr_base64_decode(uint8_t *output, size_t *output_length, char *input, size_t input_length) { (void) output; (void) output_length; (void) input; (void) input_length; return false; }
+
+// Commands are not parsed in the benchmarks
+void jsmn_init(jsmn_parser *parser) { (void) parser; }
+int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, unsigned int num_tokens) { (void) parser; (void) js; (void) len; (void) tokens; (void) num_tokens; return 0; }
+
+static bool _bench_is_peer_device(uint64_t id)
+{
+    (void) id;
+
+    return true;
+}
+
+bool twr_radio_is_peer_device(uint64_t id)
+{
+    return bench_is_peer_device(id);
+}
+
+// Sensors register but never measure unless a benchmark drives their handler
+void twr_tag_temperature_init(twr_tag_temperature_t *self, twr_i2c_channel_t i2c_channel, twr_tag_temperature_i2c_address_t i2c_address) { (void) self; (void) i2c_channel; (void) i2c_address; }
+void twr_tag_temperature_set_update_interval(twr_tag_temperature_t *self, twr_tick_t interval) { (void) self; (void) interval; }
+void twr_tag_temperature_set_event_handler(twr_tag_temperature_t *self, void (*event_handler)(twr_tag_temperature_t *, twr_tag_temperature_event_t, void *), void *event_param) { (void) self; (void) event_handler; (void) event_param; }
+bool twr_tag_temperature_get_temperature_celsius(twr_tag_temperature_t *self, float *celsius) { (void) self; (void) celsius; return false; }
+bool twr_tag_temperature_measure(twr_tag_temperature_t *self) { (void) self; return true; }
+
+void twr_tag_humidity_init(twr_tag_humidity_t *self, twr_tag_humidity_revision_t revision, twr_i2c_channel_t i2c_channel, int i2c_address) { (void) self; (void) revision; (void) i2c_channel; (void) i2c_address; }
+void twr_tag_humidity_set_update_interval(twr_tag_humidity_t *self, twr_tick_t interval) { (void) self; (void) interval; }
+void twr_tag_humidity_set_event_handler(twr_tag_humidity_t *self, void (*event_handler)(twr_tag_humidity_t *, twr_tag_humidity_event_t, void *), void *event_param) { (void) self; (void) event_handler; (void) event_param; }
+bool twr_tag_humidity_get_humidity_percentage(twr_tag_humidity_t *self, float *percentage) { (void) self; (void) percentage; return false; }
+bool twr_tag_humidity_measure(twr_tag_humidity_t *self) { (void) self; return true; }
+
+void twr_tag_lux_meter_init(twr_tag_lux_meter_t *self, twr_i2c_channel_t i2c_channel, twr_tag_lux_meter_i2c_address_t i2c_address) { (void) self; (void) i2c_channel; (void) i2c_address; }
+void twr_tag_lux_meter_set_update_interval(twr_tag_lux_meter_t *self, twr_tick_t interval) { (void) self; (void) interval; }
+
+void twr_tag_lux_meter_set_event_handler(twr_tag_lux_meter_t *self, void (*event_handler)(twr_tag_lux_meter_t *, twr_tag_lux_meter_event_t, void *), void *event_param)
+{
+    (void) self;
+
+    bench_lux_meter_handler = event_handler;
+
+    if (bench_lux_meter_count < BENCH_LUX_METER_COUNT)
+    {
+        bench_lux_meter_param[bench_lux_meter_count++] = event_param;
+    }
+}
+
+bool twr_tag_lux_meter_get_illuminance_lux(twr_tag_lux_meter_t *self, float *lux)
+{
+    (void) self;
+
+    *lux = bench_lux;
+
+    return true;
+}
+
+bool twr_tag_lux_meter_measure(twr_tag_lux_meter_t *self) { (void) self; return true; }
+
+void twr_tag_barometer_init(twr_tag_barometer_t *self, twr_i2c_channel_t i2c_channel) { (void) self; (void) i2c_channel; }
+void twr_tag_barometer_set_update_interval(twr_tag_barometer_t *self, twr_tick_t interval) { (void) self; (void) interval; }
+void twr_tag_barometer_set_event_handler(twr_tag_barometer_t *self, void (*event_handler)(twr_tag_barometer_t *, twr_tag_barometer_event_t, void *), void *event_param) { (void) self; (void) event_handler; (void) event_param; }
+bool twr_tag_barometer_get_pressure_pascal(twr_tag_barometer_t *self, float *pascal) { (void) self; (void) pascal; return false; }
+bool twr_tag_barometer_measure(twr_tag_barometer_t *self) { (void) self; return true; }
+
+void twr_module_co2_init(void) {}
+void twr_module_co2_set_update_interval(twr_tick_t interval) { (void) interval; }
+void twr_module_co2_set_event_handler(void (*event_handler)(twr_module_co2_event_t, void *), void *event_param) { (void) event_handler; (void) event_param; }
+bool twr_module_co2_get_concentration_ppm(float *ppm) { (void) ppm; return false; }
+bool twr_module_co2_measure(void) { return true; }
+
+void twr_module_pir_init(twr_module_pir_t *self) { (void) self; }
+void twr_module_pir_set_event_handler(twr_module_pir_t *self, void (*event_handler)(twr_module_pir_t *, twr_module_pir_event_t, void *), void *event_param) { (void) self; (void) event_handler; (void) event_param; }
@@ -0,0 +1,156 @@
+#ifndef _BENCH_TWR_COMMON_H
+#define _BENCH_TWR_COMMON_H
+
+// Host stand-in for the parts of the SDK the gateway modules use, see bench/sdk.c
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+
+typedef uint64_t twr_tick_t;
+
+#define TWR_TICK_INFINITY ((twr_tick_t) -1)
+
+twr_tick_t twr_tick_get(void);
+
+typedef size_t twr_scheduler_task_id_t;
+
+twr_scheduler_task_id_t twr_scheduler_register(void (*task)(void *), void *param, twr_tick_t tick);
+void twr_scheduler_plan_current_now(void);
+void twr_scheduler_plan_current_relative(twr_tick_t tick);
+void twr_scheduler_plan_current_absolute(twr_tick_t tick);
+void twr_scheduler_plan_now(twr_scheduler_task_id_t task_id);
+void twr_scheduler_plan_relative(twr_scheduler_task_id_t task_id, twr_tick_t tick);
+void twr_scheduler_plan_absolute(twr_scheduler_task_id_t task_id, twr_tick_t tick);
+twr_tick_t twr_scheduler_get_spin_tick(void);
+twr_scheduler_task_id_t twr_scheduler_get_current_task_id(void);
+
+void twr_timer_init(void);
+void twr_timer_start(void);
+uint16_t twr_timer_get_microseconds(void);
+
+typedef struct
+{
+    void *buffer;
+    size_t size;
+    size_t head;
+    size_t tail;
+
+} twr_fifo_t;
+
+void twr_fifo_init(twr_fifo_t *fifo, void *buffer, size_t size);
+
+typedef enum { TWR_UART_UART2 } twr_uart_channel_t;
+typedef enum { TWR_UART_EVENT_ASYNC_WRITE_DONE, TWR_UART_EVENT_ASYNC_READ_DATA, TWR_UART_EVENT_ASYNC_READ_TIMEOUT } twr_uart_event_t;
+
+#define TWR_UART_BAUDRATE_115200 0
+#define TWR_UART_SETTING_8N1 0
+
+void twr_uart_init(twr_uart_channel_t channel, int baudrate, int setting);
+void twr_uart_set_async_fifo(twr_uart_channel_t channel, twr_fifo_t *write_fifo, twr_fifo_t *read_fifo);
+size_t twr_uart_async_write(twr_uart_channel_t channel, const void *buffer, size_t length);
+size_t twr_uart_async_read(twr_uart_channel_t channel, void *buffer, size_t length);
+bool twr_uart_async_read_start(twr_uart_channel_t channel, twr_tick_t timeout);
+void twr_uart_set_event_handler(twr_uart_channel_t channel, void (*event_handler)(twr_uart_channel_t, twr_uart_event_t, void *), void *event_param);
+
+void twr_usb_cdc_init(void);
+bool twr_usb_cdc_write(const void *buffer, size_t length);
+size_t twr_usb_cdc_read(void *buffer, size_t length);
+
+bool twr_eeprom_write(uint32_t address, const void *buffer, size_t length);
+bool twr_eeprom_read(uint32_t address, void *buffer, size_t length);
+size_t twr_eeprom_get_size(void);
+
+size_t twr_base64_calculate_encode_length(size_t length);
+size_t twr_base64_calculate_decode_length(char *input, size_t length);
+bool twr_base64_encode(char *output, size_t *output_length, const uint8_t *input, size_t input_length);
+bool twr_base64_decode(uint8_t *output, size_t *output_length, char *input, size_t input_length);
+
+typedef enum { JSMN_UNDEFINED, JSMN_OBJECT, JSMN_ARRAY, JSMN_STRING, JSMN_PRIMITIVE } jsmntype_t;
+typedef struct { jsmntype_t type; int start; int end; int size; } jsmntok_t;
+typedef struct { unsigned int pos; } jsmn_parser;
+
+void jsmn_init(jsmn_parser *parser);
+int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, unsigned int num_tokens);
+
+#ifndef TWR_RADIO_MAX_DEVICES
+#define TWR_RADIO_MAX_DEVICES 32
+#endif
+
+bool twr_radio_is_peer_device(uint64_t id);
+
+#define TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_DEFAULT 0
+#define TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_ALTERNATE 1
+#define TWR_RADIO_PUB_CHANNEL_R2_I2C0_ADDRESS_DEFAULT 2
+#define TWR_RADIO_PUB_CHANNEL_R3_I2C0_ADDRESS_DEFAULT 4
+#define TWR_RADIO_PUB_CHANNEL_A 0x40
+#define TWR_RADIO_PUB_CHANNEL_B 0x41
+#define TWR_RADIO_PUB_CHANNEL_SET_POINT 0x42
+
+typedef enum { TWR_MODULE_RELAY_STATE_TRUE, TWR_MODULE_RELAY_STATE_FALSE, TWR_MODULE_RELAY_STATE_UNKNOWN } twr_module_relay_state_t;
+
+typedef enum { TWR_I2C_I2C0, TWR_I2C_I2C1 } twr_i2c_channel_t;
+
+typedef enum { TWR_TAG_TEMPERATURE_I2C_ADDRESS_DEFAULT = 0x48, TWR_TAG_TEMPERATURE_I2C_ADDRESS_ALTERNATE = 0x49 } twr_tag_temperature_i2c_address_t;
+typedef enum { TWR_TAG_TEMPERATURE_EVENT_ERROR, TWR_TAG_TEMPERATURE_EVENT_UPDATE } twr_tag_temperature_event_t;
+typedef struct twr_tag_temperature_t { int dummy; } twr_tag_temperature_t;
+
+void twr_tag_temperature_init(twr_tag_temperature_t *self, twr_i2c_channel_t i2c_channel, twr_tag_temperature_i2c_address_t i2c_address);
+void twr_tag_temperature_set_update_interval(twr_tag_temperature_t *self, twr_tick_t interval);
+void twr_tag_temperature_set_event_handler(twr_tag_temperature_t *self, void (*event_handler)(twr_tag_temperature_t *, twr_tag_temperature_event_t, void *), void *event_param);
+bool twr_tag_temperature_get_temperature_celsius(twr_tag_temperature_t *self, float *celsius);
+bool twr_tag_temperature_measure(twr_tag_temperature_t *self);
+
+typedef enum { TWR_TAG_HUMIDITY_REVISION_R1, TWR_TAG_HUMIDITY_REVISION_R2, TWR_TAG_HUMIDITY_REVISION_R3 } twr_tag_humidity_revision_t;
+typedef enum { TWR_TAG_HUMIDITY_EVENT_ERROR, TWR_TAG_HUMIDITY_EVENT_UPDATE } twr_tag_humidity_event_t;
+typedef struct twr_tag_humidity_t { int dummy; } twr_tag_humidity_t;
+
+#define TWR_TAG_HUMIDITY_I2C_ADDRESS_DEFAULT 0x40
+
+void twr_tag_humidity_init(twr_tag_humidity_t *self, twr_tag_humidity_revision_t revision, twr_i2c_channel_t i2c_channel, int i2c_address);
+void twr_tag_humidity_set_update_interval(twr_tag_humidity_t *self, twr_tick_t interval);
+void twr_tag_humidity_set_event_handler(twr_tag_humidity_t *self, void (*event_handler)(twr_tag_humidity_t *, twr_tag_humidity_event_t, void *), void *event_param);
+bool twr_tag_humidity_get_humidity_percentage(twr_tag_humidity_t *self, float *percentage);
+bool twr_tag_humidity_measure(twr_tag_humidity_t *self);
+
+typedef enum { TWR_TAG_LUX_METER_I2C_ADDRESS_DEFAULT = 0x44, TWR_TAG_LUX_METER_I2C_ADDRESS_ALTERNATE = 0x45 } twr_tag_lux_meter_i2c_address_t;
+typedef enum { TWR_TAG_LUX_METER_EVENT_ERROR, TWR_TAG_LUX_METER_EVENT_UPDATE } twr_tag_lux_meter_event_t;
+typedef struct twr_tag_lux_meter_t { int dummy; } twr_tag_lux_meter_t;
+
+void twr_tag_lux_meter_init(twr_tag_lux_meter_t *self, twr_i2c_channel_t i2c_channel, twr_tag_lux_meter_i2c_address_t i2c_address);
+void twr_tag_lux_meter_set_update_interval(twr_tag_lux_meter_t *self, twr_tick_t interval);
+void twr_tag_lux_meter_set_event_handler(twr_tag_lux_meter_t *self, void (*event_handler)(twr_tag_lux_meter_t *, twr_tag_lux_meter_event_t, void *), void *event_param);
+bool twr_tag_lux_meter_get_illuminance_lux(twr_tag_lux_meter_t *self, float *lux);
+bool twr_tag_lux_meter_measure(twr_tag_lux_meter_t *self);
+
+typedef enum { TWR_TAG_BAROMETER_EVENT_ERROR, TWR_TAG_BAROMETER_EVENT_UPDATE } twr_tag_barometer_event_t;
+typedef struct twr_tag_barometer_t { int dummy; } twr_tag_barometer_t;
+
+void twr_tag_barometer_init(twr_tag_barometer_t *self, twr_i2c_channel_t i2c_channel);
+void twr_tag_barometer_set_update_interval(twr_tag_barometer_t *self, twr_tick_t interval);
+void twr_tag_barometer_set_event_handler(twr_tag_barometer_t *self, void (*event_handler)(twr_tag_barometer_t *, twr_tag_barometer_event_t, void *), void *event_param);
+bool twr_tag_barometer_get_pressure_pascal(twr_tag_barometer_t *self, float *pascal);
+bool twr_tag_barometer_measure(twr_tag_barometer_t *self);
+
+typedef enum { TWR_MODULE_CO2_EVENT_ERROR, TWR_MODULE_CO2_EVENT_UPDATE } twr_module_co2_event_t;
+
+void twr_module_co2_init(void);
+void twr_module_co2_set_update_interval(twr_tick_t interval);
+void twr_module_co2_set_event_handler(void (*event_handler)(twr_module_co2_event_t, void *), void *event_param);
+bool twr_module_co2_get_concentration_ppm(float *ppm);
+bool twr_module_co2_measure(void);
+
+typedef struct { int dummy; } twr_module_pir_t;
+typedef enum { TWR_MODULE_PIR_EVENT_ERROR, TWR_MODULE_PIR_EVENT_MOTION } twr_module_pir_event_t;
+
+void twr_module_pir_init(twr_module_pir_t *self);
+void twr_module_pir_set_event_handler(twr_module_pir_t *self, void (*event_handler)(twr_module_pir_t *, twr_module_pir_event_t, void *), void *event_param);
+
+#endif // _BENCH_TWR_COMMON_H
@@ -0,0 +1 @@
+#include <twr_common.h>
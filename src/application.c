@@ -2,6 +2,14 @@
 #include <radio.h>
 #include <usb_talk.h>
 #include <eeprom.h>
+#include <config.h>
+#include <precision.h>
+#include <batch.h>
+#include <filter.h>
+#include <retained.h>
+#include <deadband.h>
+#include <timesync.h>
+#include <stats.h>
 #if CORE_MODULE
 #include <sensors.h>
 #endif
@@ -54,10 +62,42 @@ static void pairing_start(uint64_t *id, usb_talk_payload_t *payload, usb_talk_su
 static void pairing_stop(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 static void automatic_pairing_start(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 static void automatic_pairing_stop(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void buffer_format_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void buffer_format_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void envelope_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void envelope_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void timestamp_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void timestamp_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void time_sync(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void time_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_latency_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_latency_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_tasks_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_tasks_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_buffers_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_buffers_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_stack_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void stats_sensors_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void precision_table_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void precision_table_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void batch_config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void batch_config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void filter_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void filter_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void retained_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void retained_purge(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void deadband_config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void deadband_config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 
 static void alias_add(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 static void alias_remove(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 static void alias_list(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void alias_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void alias_dump(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+
+static void config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
+static void config_list_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 
 static void radio_sub_callback(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub);
 
@@ -90,13 +130,49 @@ const usb_talk_subscribe_t subscribes[] = {
     {"/pairing-mode/stop", pairing_stop, 0, NULL},
     {"/automatic-pairing/start", automatic_pairing_start, 0, NULL},
     {"/automatic-pairing/stop", automatic_pairing_stop, 0, NULL},
+    {"/buffer/format/set", buffer_format_set, 0, NULL},
+    {"/buffer/format/get", buffer_format_get, 0, NULL},
+    {"/envelope/set", envelope_set, 0, NULL},
+    {"/envelope/get", envelope_get, 0, NULL},
+    {"/timestamp/set", timestamp_set, 0, NULL},
+    {"/timestamp/get", timestamp_get, 0, NULL},
+    {"/time/sync", time_sync, 0, NULL},
+    {"/time/get", time_get, 0, NULL},
+    {"/stats/latency/get", stats_latency_get, 0, NULL},
+    {"/stats/latency/reset", stats_latency_clear, 0, NULL},
+    {"/stats/tasks/get", stats_tasks_get, 0, NULL},
+    {"/stats/tasks/reset", stats_tasks_clear, 0, NULL},
+    {"/stats/buffers/get", stats_buffers_get, 0, NULL},
+    {"/stats/buffers/reset", stats_buffers_clear, 0, NULL},
+    {"/stats/stack/get", stats_stack_get, 0, NULL},
+    {"/stats/sensors/get", stats_sensors_get, 0, NULL},
+    {"/precision/set", precision_table_set, 0, NULL},
+    {"/precision/get", precision_table_get, 0, NULL},
+    {"/batch/set", batch_config_set, 0, NULL},
+    {"/batch/get", batch_config_get, 0, NULL},
+    {"/filter/set", filter_set, 0, NULL},
+    {"/filter/get", filter_get, 0, NULL},
+    {"/retained/get", retained_get, 0, NULL},
+    {"/retained/purge", retained_purge, 0, NULL},
+    {"/deadband/set", deadband_config_set, 0, NULL},
+    {"/deadband/get", deadband_config_get, 0, NULL},
     {"$eeprom/alias/add", alias_add, 0, NULL},
     {"$eeprom/alias/remove", alias_remove, 0, NULL},
     {"$eeprom/alias/list", alias_list, 0, NULL},
+    {"$eeprom/alias/set", alias_set, 0, NULL},
+    {"$eeprom/alias/dump", alias_dump, 0, NULL},
+    {"$config/get", config_get, 0, NULL},
+    {"$config/set", config_set, 0, NULL},
+    {"$config/list", config_list_get, 0, NULL},
 };
 
 void application_init(void)
 {
+    // First thing, the stack is shallow here and nothing runs on it yet
+    stats_stack_paint();
+
+    stats_init();
+
     twr_led_init(&led, GPIO_LED, false, false);
     twr_led_set_mode(&led, TWR_LED_MODE_OFF);
 
@@ -108,6 +184,11 @@ void application_init(void)
 
     eeprom_init();
 
+    batch_init();
+
+    // Applies the stored settings, so after the modules it configures
+    config_init();
+
 #if CORE_MODULE
     twr_module_power_init();
 
@@ -178,82 +259,146 @@ static void radio_event_handler(twr_radio_event_t event, void *event_param)
 
 void twr_radio_pub_on_event_count(uint64_t *id, uint8_t event_id, uint16_t *event_count)
 {
+    usb_talk_event_begin(STATS_EVENT_EVENT_COUNT);
+
     twr_led_pulse(&led, 10);
 
+    const char *name;
+
     if (event_id == TWR_RADIO_PUB_EVENT_PUSH_BUTTON)
     {
-        usb_talk_publish_event_count(id, "push-button/-", event_count);
+        name = "push-button/-";
     }
     else if (event_id == TWR_RADIO_PUB_EVENT_PIR_MOTION)
     {
-        usb_talk_publish_event_count(id, "pir/-", event_count);
+        name = "pir/-";
     }
     else if (event_id == TWR_RADIO_PUB_EVENT_LCD_BUTTON_LEFT)
     {
-        usb_talk_publish_event_count(id, "push-button/lcd:left", event_count);
+        name = "push-button/lcd:left";
     }
     else if (event_id == TWR_RADIO_PUB_EVENT_LCD_BUTTON_RIGHT)
     {
-        usb_talk_publish_event_count(id, "push-button/lcd:right", event_count);
+        name = "push-button/lcd:right";
     }
     else if (event_id == TWR_RADIO_PUB_EVENT_ACCELEROMETER_ALERT)
     {
-        usb_talk_publish_event_count(id, "accelerometer/-", event_count);
+        name = "accelerometer/-";
     }
     else if (event_id == TWR_RADIO_PUB_EVENT_HOLD_BUTTON)
     {
-        usb_talk_send_format("[\"%012llx/push-button/-/hold-count\", %" PRIu16 "]\n", *id, *event_count);
+        if (!filter_pass(id, "push-button"))
+        {
+            return;
+        }
+
+        uint32_t value = *event_count;
+
+        usb_talk_publish_uint32(id, "push-button/-/hold-count", &value);
+
+        return;
+    }
+    else
+    {
+        return;
+    }
+
+    if (!filter_pass(id, name))
+    {
+        return;
     }
+
+    usb_talk_publish_event_count(id, name, event_count);
 }
 
 void twr_radio_pub_on_temperature(uint64_t *id, uint8_t channel, float *celsius)
 {
+    usb_talk_event_begin(STATS_EVENT_THERMOMETER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "thermometer"))
+    {
+        return;
+    }
+
     usb_talk_publish_temperature(id, channel, celsius);
 }
 
 void twr_radio_pub_on_humidity(uint64_t *id, uint8_t channel, float *percentage)
 {
+    usb_talk_event_begin(STATS_EVENT_HYGROMETER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "hygrometer"))
+    {
+        return;
+    }
+
     usb_talk_publish_humidity(id, channel, percentage);
 }
 
 void twr_radio_pub_on_lux_meter(uint64_t *id, uint8_t channel, float *illuminance)
 {
+    usb_talk_event_begin(STATS_EVENT_LUX_METER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "lux-meter"))
+    {
+        return;
+    }
+
     usb_talk_publish_lux_meter(id, channel, illuminance);
 }
 
 void twr_radio_pub_on_barometer(uint64_t *id, uint8_t channel, float *pressure, float *altitude)
 {
+    usb_talk_event_begin(STATS_EVENT_BAROMETER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "barometer"))
+    {
+        return;
+    }
+
     usb_talk_publish_barometer(id, channel, pressure, altitude);
 }
 
 void twr_radio_pub_on_co2(uint64_t *id, float *concentration)
 {
+    usb_talk_event_begin(STATS_EVENT_CO2_METER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "co2-meter"))
+    {
+        return;
+    }
+
     usb_talk_publish_co2(id, concentration);
 }
 
 void twr_radio_pub_on_battery(uint64_t *id, float *voltage)
 {
-    twr_led_pulse(&led, 10);
+    usb_talk_event_begin(STATS_EVENT_BATTERY);
 
-    usb_talk_message_start_id(id, "battery/-/voltage");
+    twr_led_pulse(&led, 10);
 
-    usb_talk_message_append_float("%.2f", voltage);
+    if (!filter_pass(id, "battery"))
+    {
+        return;
+    }
 
-    usb_talk_message_send();
+    usb_talk_publish_battery(id, voltage);
 }
 
 void twr_radio_pub_on_state(uint64_t *id, uint8_t who, bool *state)
 {
+    usb_talk_event_begin(STATS_EVENT_STATE);
+
     twr_led_pulse(&led, 10);
 
     static const char *lut[] = {
@@ -263,7 +408,7 @@ void twr_radio_pub_on_state(uint64_t *id, uint8_t who, bool *state)
             [TWR_RADIO_PUB_STATE_POWER_MODULE_RELAY] = "relay/-/state"
     };
 
-    if (who < 4)
+    if ((who < 4) && filter_pass(id, lut[who]))
     {
         usb_talk_publish_bool(id, lut[who], state);
     }
@@ -271,33 +416,90 @@ void twr_radio_pub_on_state(uint64_t *id, uint8_t who, bool *state)
 
 void twr_radio_pub_on_value_int(uint64_t *id, uint8_t value_id, int *value)
 {
+    usb_talk_event_begin(STATS_EVENT_VALUE);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "push-button"))
+    {
+        return;
+    }
+
     if (value_id == TWR_RADIO_PUB_VALUE_HOLD_DURATION_BUTTON)
     {
-        usb_talk_send_format("[\"%012llx/push-button/-/hold-duration\", %d]\n", *id, *value);
+        usb_talk_message_start_id(id, "push-button/-/hold-duration");
+
+        usb_talk_message_int(*value);
+
+        usb_talk_message_send();
     }
 }
 
 void twr_radio_pub_on_acceleration(uint64_t *id, float *x_axis, float *y_axis, float *z_axis)
 {
+    usb_talk_event_begin(STATS_EVENT_ACCELEROMETER);
+
     twr_led_pulse(&led, 10);
 
-    usb_talk_publish_accelerometer_acceleration(id, x_axis, y_axis, z_axis);
+    if (!filter_pass(id, "accelerometer"))
+    {
+        return;
+    }
+
+    if (batch_acceleration(id, x_axis, y_axis, z_axis))
+    {
+        retained_vector(id, "accelerometer/-/acceleration", x_axis, y_axis, z_axis);
+    }
+    else
+    {
+        usb_talk_publish_accelerometer_acceleration(id, x_axis, y_axis, z_axis);
+    }
 }
 
 void twr_radio_pub_on_buffer(uint64_t *id, void *buffer, size_t length)
 {
+    usb_talk_event_begin(STATS_EVENT_BUFFER);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, "buffer"))
+    {
+        return;
+    }
+
     usb_talk_publish_buffer(id, buffer, length);
 }
 
 void twr_radio_on_info(uint64_t *id, char *firmware, char *version, twr_radio_mode_t mode)
 {
+    usb_talk_event_begin(STATS_EVENT_INFO);
+
     twr_led_pulse(&led, 10);
 
-    usb_talk_send_format("[\"" USB_TALK_DEVICE_ADDRESS "/info\", {\"firmware\": \"%s\", \"version\": \"%s\", \"mode\": %d}]\n", *id, firmware, version, mode);
+    if (!filter_pass(id, "info"))
+    {
+        return;
+    }
+
+    usb_talk_message_start_id(id, "info");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("firmware");
+
+    usb_talk_message_string(firmware);
+
+    usb_talk_message_key("version");
+
+    usb_talk_message_string(version);
+
+    usb_talk_message_key("mode");
+
+    usb_talk_message_int(mode);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
 }
 
 void twr_radio_on_sub(uint64_t *id, uint8_t *number, twr_radio_sub_pt_t *pt, char *topic)
@@ -308,56 +510,121 @@ void twr_radio_on_sub(uint64_t *id, uint8_t *number, twr_radio_sub_pt_t *pt, cha
 
     usb_talk_add_sub(topic, radio_sub_callback, *number, (void *) payload_type); // Small trick, save number as pointer
 
-    usb_talk_send_format("[\"$sub\", {\"topic\": \"" USB_TALK_DEVICE_ADDRESS "/%s\", \"pt\": %d}]\n", *id, topic, *pt);
+    char sub_topic[13 + USB_TALK_SUB_TOPIC_MAX_LENGTH];
+
+    snprintf(sub_topic, sizeof(sub_topic), USB_TALK_DEVICE_ADDRESS "/%s", *id, topic);
+
+    usb_talk_message_start("$sub");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("topic");
 
+    usb_talk_message_string(sub_topic);
+
+    usb_talk_message_key("pt");
+
+    usb_talk_message_int(*pt);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
 }
 
 void twr_radio_pub_on_bool(uint64_t *id, char *subtopic, bool *value)
 {
+    usb_talk_event_begin(STATS_EVENT_GENERIC);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, subtopic))
+    {
+        return;
+    }
+
+    if (!deadband_bool(id, subtopic, value))
+    {
+        // Held back values still go to the cache, a replay gives the latest one
+        retained_bool(id, subtopic, *value);
+
+        return;
+    }
+
     usb_talk_publish_bool(id, subtopic, value);
 }
 
 void twr_radio_pub_on_int(uint64_t *id, char *subtopic, int *value)
 {
+    usb_talk_event_begin(STATS_EVENT_GENERIC);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, subtopic))
+    {
+        return;
+    }
+
+    if (!deadband_int(id, subtopic, value))
+    {
+        // Held back values still go to the cache, a replay gives the latest one
+        retained_int(id, subtopic, *value);
+
+        return;
+    }
+
     usb_talk_publish_int(id, subtopic, value);
 }
 
 void twr_radio_pub_on_float(uint64_t *id, char *subtopic, float *value)
 {
+    usb_talk_event_begin(STATS_EVENT_GENERIC);
+
     twr_led_pulse(&led, 10);
 
+    if (!filter_pass(id, subtopic))
+    {
+        return;
+    }
+
+    if (!deadband_float(id, subtopic, value))
+    {
+        // Held back values still go to the cache, a replay gives the latest one
+        retained_float(id, subtopic, value);
+
+        return;
+    }
+
     usb_talk_publish_float(id, subtopic, value);
 }
 
 void twr_radio_pub_on_uint32(uint64_t *id, char *subtopic, uint32_t *value)
 {
-    twr_led_pulse(&led, 10);
+    usb_talk_event_begin(STATS_EVENT_GENERIC);
 
-    usb_talk_message_start_id(id, subtopic);
+    twr_led_pulse(&led, 10);
 
-    if (value == NULL)
-    {
-        usb_talk_message_append("null");
-    }
-    else
+    if (!filter_pass(id, subtopic))
     {
-        usb_talk_message_append("%u", *value);
+        return;
     }
 
-    usb_talk_message_send();
+    usb_talk_publish_uint32(id, subtopic, value);
 }
 
 void twr_radio_pub_on_string(uint64_t *id, char *subtopic, char *value)
 {
+    usb_talk_event_begin(STATS_EVENT_GENERIC);
+
     twr_led_pulse(&led, 10);
 
-    usb_talk_message_start_id(id, subtopic);
+    if (!filter_pass(id, subtopic))
+    {
+        return;
+    }
+
+    usb_talk_message_start_id(id, "%s", subtopic);
 
-    usb_talk_message_append("\"%s\"", value);
+    usb_talk_message_string(value);
 
     usb_talk_message_send();
 }
@@ -921,136 +1188,749 @@ static void automatic_pairing_stop(uint64_t *id, usb_talk_payload_t *payload, us
     usb_talk_send_string("[\"/automatic-pairing\", \"stop\"]\n");
 }
 
-static void alias_add(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+static void buffer_format_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
 {
-    (void) id;
-    (void) sub;
-
-    uint64_t node_id;
+    int format;
 
-    if (!usb_talk_payload_get_key_node_id(payload, "id", &node_id))
+    if (!usb_talk_payload_get_enum(payload, &format, "array", "base64", "hex", NULL))
     {
         return;
     }
 
-    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
-    size_t length = sizeof(name);
+    config_set_int(CONFIG_KEY_BUFFER_FORMAT, format);
 
-    if (!usb_talk_payload_get_key_string(payload, "name", name, &length))
+    buffer_format_get(id, payload, sub);
+}
+
+static void buffer_format_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    static const char *lut[] = {
+            [USB_TALK_BUFFER_FORMAT_ARRAY] = "array",
+            [USB_TALK_BUFFER_FORMAT_BASE64] = "base64",
+            [USB_TALK_BUFFER_FORMAT_HEX] = "hex"
+    };
+
+    usb_talk_send_format("[\"/buffer/format\", \"%s\"]\n", lut[usb_talk_get_buffer_format()]);
+}
+
+static void envelope_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    bool enable;
+
+    if (!usb_talk_payload_get_bool(payload, &enable))
     {
         return;
     }
 
-    eeprom_alias_add(&node_id, name);
+    config_set_bool(CONFIG_KEY_ENVELOPE, enable);
+
+    envelope_get(id, payload, sub);
 }
 
-static void alias_remove(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+static void envelope_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
 {
     (void) id;
+    (void) payload;
     (void) sub;
 
-    uint64_t node_id;
+    usb_talk_send_format("[\"/envelope\", %s]\n", usb_talk_get_envelope() ? "true" : "false");
+}
 
-    if (!usb_talk_payload_get_node_id(payload, &node_id))
+static void timestamp_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    bool enable;
+
+    if (!usb_talk_payload_get_bool(payload, &enable))
     {
         return;
     }
 
-    eeprom_alias_remove(&node_id);
+    config_set_bool(CONFIG_KEY_TIMESTAMP, enable);
+
+    timestamp_get(id, payload, sub);
 }
 
-static void alias_list(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+static void timestamp_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
 {
     (void) id;
+    (void) payload;
     (void) sub;
 
-    int page;
+    usb_talk_send_format("[\"/timestamp\", %s]\n", usb_talk_get_timestamp() ? "true" : "false");
+}
 
-    if (!usb_talk_payload_get_int(payload, &page))
+static void time_sync(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    uint64_t time;
+
+    // Host time in ms, usually since the Unix epoch
+    if (!usb_talk_payload_get_uint64(payload, &time))
     {
         return;
     }
 
-    eeprom_alias_list(page);
+    timesync_set(time);
+
+    time_get(id, payload, sub);
 }
 
-static void radio_sub_callback(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+static void time_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
 {
-    twr_radio_sub_pt_t payload_type = (twr_radio_sub_pt_t) sub->param;
+    (void) id;
+    (void) payload;
+    (void) sub;
 
-    uint8_t value[41];
+    twr_tick_t tick = twr_tick_get();
 
-    size_t value_size = 0;
+    usb_talk_message_start("/time");
 
-    switch (payload_type) {
-        case TWR_RADIO_SUB_PT_BOOL:
-        {
-            if (!usb_talk_payload_get_bool(payload, (bool *) value))
-            {
-                return;
-            }
+    usb_talk_message_object_begin();
 
-            value_size = sizeof(bool);
+    usb_talk_message_key("tick");
 
-            break;
-        }
-        case TWR_RADIO_SUB_PT_INT:
-        {
-            if (!usb_talk_payload_get_int(payload, (int *) value))
-            {
-                return;
-            }
+    usb_talk_message_uint64(tick);
 
-            value_size = sizeof(int);
+    usb_talk_message_key("time");
 
-            break;
-        }
-        case TWR_RADIO_SUB_PT_FLOAT:
-        {
-            if (!usb_talk_payload_get_float(payload, (float *) value))
-            {
-                return;
-            }
+    usb_talk_message_uint64(timesync_get(tick));
 
-            value_size = sizeof(float);
+    usb_talk_message_key("synced");
 
-            break;
-        }
-        case TWR_RADIO_SUB_PT_STRING:
-        {
-            value_size = sizeof(value);
+    usb_talk_message_bool(timesync_is_synced());
 
-            if (!usb_talk_payload_get_string(payload, (char *) value, &value_size))
-            {
-                return;
-            }
+    usb_talk_message_object_end();
 
-            value_size += 1;
+    usb_talk_message_send();
+}
 
-            break;
-        }
-        case TWR_RADIO_SUB_PT_NULL:
-        {
-            break;
-        }
-        default:
-        {
-            return;
-        }
-    }
+static void stats_latency_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
 
-    twr_radio_send_sub_data(id, sub->number, value, value_size);
+    stats_latency_list();
 }
 
-#if CORE_MODULE
-void application_task(void)
+static void stats_latency_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
 {
-    twr_tick_t now = twr_tick_get();
-    if (lcd.next_update < now)
-    {
-        twr_module_lcd_update();
-        lcd.next_update = now + 500;
-    }
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    stats_latency_reset();
+
+    stats_latency_list();
+}
+
+static void stats_tasks_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    stats_task_list();
+}
+
+static void stats_tasks_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    stats_task_reset();
+
+    stats_task_list();
+}
+
+static void stats_buffers_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    usb_talk_buffers_list();
+}
+
+static void stats_buffers_clear(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    usb_talk_buffers_reset();
+
+    usb_talk_buffers_list();
+}
+
+static void stats_stack_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    stats_stack_list();
+}
+
+static void stats_sensors_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+#if CORE_MODULE
+    sensors_list();
+#else
+    usb_talk_send_string("[\"/stats/sensors\", []]\n");
+#endif
+}
+
+static void precision_table_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    char name[20];
+    size_t length = sizeof(name);
+    precision_class_t precision_class;
+    int digits;
+
+    if (!usb_talk_payload_get_key_string(payload, "name", name, &length))
+    {
+        return;
+    }
+
+    if (!precision_class_find_name(name, &precision_class))
+    {
+        return;
+    }
+
+    if (usb_talk_payload_get_key_int(payload, "decimals", &digits) && (digits >= 0))
+    {
+        precision_set(precision_class, PRECISION_MODE_DECIMALS, digits);
+    }
+    else if (usb_talk_payload_get_key_int(payload, "digits", &digits) && (digits > 0))
+    {
+        precision_set(precision_class, PRECISION_MODE_DIGITS, digits);
+    }
+    else
+    {
+        return;
+    }
+
+    precision_table_get(id, payload, sub);
+}
+
+static void precision_table_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    precision_list();
+}
+
+static void batch_config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    int count;
+    int timeout;
+
+    if (!usb_talk_payload_get_key_int(payload, "count", &count))
+    {
+        return;
+    }
+
+    if (!usb_talk_payload_get_key_int(payload, "timeout", &timeout) || (timeout < 0))
+    {
+        timeout = BATCH_TIMEOUT_DEFAULT;
+    }
+
+    if (count < 0)
+    {
+        count = 0;
+    }
+    else if (count > BATCH_SAMPLE_MAX)
+    {
+        count = BATCH_SAMPLE_MAX;
+    }
+
+    if (timeout > BATCH_TIMEOUT_MAX)
+    {
+        timeout = BATCH_TIMEOUT_MAX;
+    }
+
+    config_set_int(CONFIG_KEY_BATCH_TIMEOUT, timeout);
+
+    config_set_int(CONFIG_KEY_BATCH_COUNT, count);
+
+    batch_config_get(id, payload, sub);
+}
+
+static void batch_config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    int count;
+    twr_tick_t timeout;
+
+    batch_get(&count, &timeout);
+
+    usb_talk_message_start("/batch");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("count");
+
+    usb_talk_message_int(count);
+
+    usb_talk_message_key("timeout");
+
+    usb_talk_message_uint(timeout);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+static void filter_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    jsmntok_t *tokens = payload->tokens;
+
+    // {"include": ["+/thermometer", ...], "exclude": [...]}, anything but an object clears the filter
+    if (tokens[0].type == JSMN_OBJECT)
+    {
+        // Every value must be an array of strings, then each array takes its size in tokens
+        int i = 1;
+
+        for (int k = 0; k < tokens[0].size; k++)
+        {
+            if ((i + 1 >= payload->token_count) || (tokens[i + 1].type != JSMN_ARRAY))
+            {
+                return;
+            }
+
+            int size = tokens[i + 1].size;
+
+            i += 2;
+
+            for (int j = 0; j < size; j++, i++)
+            {
+                if ((i >= payload->token_count) || (tokens[i].type != JSMN_STRING))
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    filter_clear();
+
+    if (tokens[0].type == JSMN_OBJECT)
+    {
+        int i = 1;
+
+        for (int k = 0; k < tokens[0].size; k++)
+        {
+            jsmntok_t *key = &tokens[i];
+            jsmntok_t *value = &tokens[i + 1];
+
+            i += 2;
+
+            bool include = usb_talk_is_string_token_equal(payload->buffer, key, "include");
+
+            if (include || usb_talk_is_string_token_equal(payload->buffer, key, "exclude"))
+            {
+                for (int j = 0; j < value->size; j++)
+                {
+                    jsmntok_t *pattern = &tokens[i + j];
+
+                    filter_add(include, payload->buffer + pattern->start, pattern->end - pattern->start);
+                }
+            }
+
+            i += value->size;
+        }
+    }
+
+    filter_get(id, payload, sub);
+}
+
+static void filter_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    filter_list();
+}
+
+static void retained_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    retained_replay();
+}
+
+static void retained_purge(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    retained_clear();
+
+    retained_replay();
+}
+
+static void deadband_config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    char name[20];
+    size_t length = sizeof(name);
+    float change;
+    int interval;
+
+    if (!usb_talk_payload_get_key_string(payload, "name", name, &length))
+    {
+        return;
+    }
+
+    if (!usb_talk_payload_get_key_float(payload, "change", &change))
+    {
+        change = 0.f;
+    }
+
+    if (!usb_talk_payload_get_key_int(payload, "interval", &interval) || (interval < 0))
+    {
+        interval = DEADBAND_INTERVAL_DEFAULT;
+    }
+
+    if (!deadband_set(name, change, interval))
+    {
+        return;
+    }
+
+    deadband_config_get(id, payload, sub);
+}
+
+static void deadband_config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    deadband_list();
+}
+
+static void alias_add(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    uint64_t node_id;
+
+    if (!usb_talk_payload_get_key_node_id(payload, "id", &node_id))
+    {
+        return;
+    }
+
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+    size_t length = sizeof(name);
+
+    if (!usb_talk_payload_get_key_string(payload, "name", name, &length))
+    {
+        return;
+    }
+
+    eeprom_alias_add(&node_id, name);
+}
+
+static void alias_remove(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    uint64_t node_id;
+
+    if (!usb_talk_payload_get_node_id(payload, &node_id))
+    {
+        return;
+    }
+
+    eeprom_alias_remove(&node_id);
+}
+
+static void alias_list(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    int page;
+
+    if (!usb_talk_payload_get_int(payload, &page))
+    {
+        return;
+    }
+
+    eeprom_alias_list(page);
+}
+
+static void alias_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    int count = usb_talk_payload_get_object_size(payload);
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    uint64_t node_id;
+
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+
+    size_t names_length = 0;
+
+    // Names are checked and measured first, the store reserves room for all of them at once
+    for (int i = 0; i < count; i++)
+    {
+        size_t length = sizeof(name);
+
+        if (!usb_talk_payload_get_pair_node_id(payload, i, &node_id, name, &length))
+        {
+            usb_talk_send_format("[\"$eeprom/alias/set/error\", %d]\n", count);
+
+            return;
+        }
+
+        names_length += length;
+    }
+
+    if (!eeprom_alias_begin(count, names_length))
+    {
+        usb_talk_send_format("[\"$eeprom/alias/set/error\", %d]\n", count);
+
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        size_t length = sizeof(name);
+
+        if (!usb_talk_payload_get_pair_node_id(payload, i, &node_id, name, &length) || !eeprom_alias_stage(&node_id, name))
+        {
+            eeprom_alias_abort();
+
+            usb_talk_send_format("[\"$eeprom/alias/set/error\", %d]\n", count);
+
+            return;
+        }
+    }
+
+    if (!eeprom_alias_commit())
+    {
+        usb_talk_send_format("[\"$eeprom/alias/set/error\", %d]\n", count);
+
+        return;
+    }
+
+    usb_talk_send_format("[\"$eeprom/alias/set/ok\", %d]\n", count);
+}
+
+static void alias_dump(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) payload;
+    (void) sub;
+
+    eeprom_alias_dump();
+}
+
+static void config_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    char name[32];
+    size_t length = sizeof(name);
+    config_key_t key;
+
+    if (!usb_talk_payload_get_string(payload, name, &length) || !config_find(name, &key))
+    {
+        return;
+    }
+
+    config_send(key);
+}
+
+static void config_set(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    char name[32];
+    size_t length = sizeof(name);
+    config_key_t key;
+
+    if (!usb_talk_payload_get_key_string(payload, "name", name, &length) || !config_find(name, &key))
+    {
+        return;
+    }
+
+    bool ok = false;
+
+    switch (config_get_type(key))
+    {
+        case CONFIG_TYPE_BOOL:
+        {
+            bool value;
+
+            ok = usb_talk_payload_get_key_bool(payload, "value", &value) && config_set_bool(key, value);
+
+            break;
+        }
+        case CONFIG_TYPE_INT:
+        {
+            int value;
+
+            ok = usb_talk_payload_get_key_int(payload, "value", &value) && config_set_int(key, value);
+
+            break;
+        }
+        case CONFIG_TYPE_FLOAT:
+        {
+            float value;
+
+            ok = usb_talk_payload_get_key_float(payload, "value", &value) && config_set_float(key, value);
+
+            break;
+        }
+        case CONFIG_TYPE_ENUM:
+        {
+            char value[16];
+
+            length = sizeof(value);
+
+            ok = usb_talk_payload_get_key_string(payload, "value", value, &length) && config_set_enum(key, value);
+
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    if (!ok)
+    {
+        return;
+    }
+
+    config_send(key);
+}
+
+static void config_list_get(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    (void) id;
+    (void) sub;
+
+    int page;
+
+    if (!usb_talk_payload_get_int(payload, &page))
+    {
+        return;
+    }
+
+    config_list(page);
+}
+
+static void radio_sub_callback(uint64_t *id, usb_talk_payload_t *payload, usb_talk_subscribe_t *sub)
+{
+    twr_radio_sub_pt_t payload_type = (twr_radio_sub_pt_t) sub->param;
+
+    uint8_t value[41];
+
+    size_t value_size = 0;
+
+    switch (payload_type) {
+        case TWR_RADIO_SUB_PT_BOOL:
+        {
+            if (!usb_talk_payload_get_bool(payload, (bool *) value))
+            {
+                return;
+            }
+
+            value_size = sizeof(bool);
+
+            break;
+        }
+        case TWR_RADIO_SUB_PT_INT:
+        {
+            if (!usb_talk_payload_get_int(payload, (int *) value))
+            {
+                return;
+            }
+
+            value_size = sizeof(int);
+
+            break;
+        }
+        case TWR_RADIO_SUB_PT_FLOAT:
+        {
+            if (!usb_talk_payload_get_float(payload, (float *) value))
+            {
+                return;
+            }
+
+            value_size = sizeof(float);
+
+            break;
+        }
+        case TWR_RADIO_SUB_PT_STRING:
+        {
+            value_size = sizeof(value);
+
+            if (!usb_talk_payload_get_string(payload, (char *) value, &value_size))
+            {
+                return;
+            }
+
+            value_size += 1;
+
+            break;
+        }
+        case TWR_RADIO_SUB_PT_NULL:
+        {
+            break;
+        }
+        default:
+        {
+            return;
+        }
+    }
+
+    twr_radio_send_sub_data(id, sub->number, value, value_size);
+}
+
+#if CORE_MODULE
+void application_task(void)
+{
+    stats_mark_t start = stats_mark();
+
+    twr_tick_t now = start.tick;
+    if (lcd.next_update < now)
+    {
+        twr_module_lcd_update();
+        lcd.next_update = now + 500;
+    }
+
+    stats_task(STATS_TASK_APPLICATION, start);
 
     twr_scheduler_plan_current_relative(500);
 }
@@ -0,0 +1,242 @@
+#include <batch.h>
+#include <usb_talk.h>
+#include <precision.h>
+#include <timesync.h>
+#include <stats.h>
+#include <twr_scheduler.h>
+
+typedef struct
+{
+    uint64_t id;
+    uint8_t length;
+    twr_tick_t timestamp;
+    uint16_t offset[BATCH_SAMPLE_MAX];
+    float sample[BATCH_SAMPLE_MAX][3];
+
+} batch_slot_t;
+
+static struct
+{
+    int count;
+    twr_tick_t timeout;
+
+    batch_slot_t slot[BATCH_SLOT_COUNT];
+
+    twr_scheduler_task_id_t task_id;
+
+} _batch;
+
+static void _batch_task(void *param);
+static void _batch_slot_send(batch_slot_t *slot);
+static void _batch_plan(void);
+
+void batch_init(void)
+{
+    memset(&_batch, 0, sizeof(_batch));
+
+    _batch.timeout = BATCH_TIMEOUT_DEFAULT;
+
+    _batch.task_id = twr_scheduler_register(_batch_task, NULL, TWR_TICK_INFINITY);
+}
+
+void batch_set(int count, twr_tick_t timeout)
+{
+    batch_flush();
+
+    if (count < 0)
+    {
+        count = 0;
+    }
+    else if (count > BATCH_SAMPLE_MAX)
+    {
+        count = BATCH_SAMPLE_MAX;
+    }
+
+    if (timeout > BATCH_TIMEOUT_MAX)
+    {
+        timeout = BATCH_TIMEOUT_MAX;
+    }
+
+    _batch.count = count;
+    _batch.timeout = timeout;
+}
+
+void batch_get(int *count, twr_tick_t *timeout)
+{
+    *count = _batch.count;
+    *timeout = _batch.timeout;
+}
+
+bool batch_acceleration(uint64_t *id, float *x_axis, float *y_axis, float *z_axis)
+{
+    if (_batch.count < 2)
+    {
+        return false;
+    }
+
+    twr_tick_t now = twr_tick_get();
+
+    batch_slot_t *slot = NULL;
+    batch_slot_t *oldest = NULL;
+
+    for (int i = 0; i < BATCH_SLOT_COUNT; i++)
+    {
+        batch_slot_t *s = &_batch.slot[i];
+
+        if (s->length == 0)
+        {
+            if (slot == NULL)
+            {
+                slot = s;
+            }
+
+            continue;
+        }
+
+        if (s->id == *id)
+        {
+            slot = s;
+
+            break;
+        }
+
+        if ((oldest == NULL) || (s->timestamp < oldest->timestamp))
+        {
+            oldest = s;
+        }
+    }
+
+    if (slot == NULL)
+    {
+        // All slots taken by other nodes, make room
+        _batch_slot_send(oldest);
+
+        slot = oldest;
+    }
+
+    if ((slot->length != 0) && (slot->timestamp + _batch.timeout <= now))
+    {
+        // Timeout task did not run yet, keep offsets within the timeout
+        _batch_slot_send(slot);
+    }
+
+    if (slot->length == 0)
+    {
+        slot->id = *id;
+        slot->timestamp = now;
+    }
+
+    slot->offset[slot->length] = (uint16_t) (now - slot->timestamp);
+    slot->sample[slot->length][0] = x_axis != NULL ? *x_axis : NAN;
+    slot->sample[slot->length][1] = y_axis != NULL ? *y_axis : NAN;
+    slot->sample[slot->length][2] = z_axis != NULL ? *z_axis : NAN;
+    slot->length++;
+
+    if (slot->length >= _batch.count)
+    {
+        _batch_slot_send(slot);
+    }
+
+    _batch_plan();
+
+    return true;
+}
+
+void batch_flush(void)
+{
+    for (int i = 0; i < BATCH_SLOT_COUNT; i++)
+    {
+        _batch_slot_send(&_batch.slot[i]);
+    }
+
+    _batch_plan();
+}
+
+static void _batch_task(void *param)
+{
+    (void) param;
+
+    stats_mark_t start = stats_mark();
+
+    twr_tick_t now = start.tick;
+
+    for (int i = 0; i < BATCH_SLOT_COUNT; i++)
+    {
+        if ((_batch.slot[i].length != 0) && (_batch.slot[i].timestamp + _batch.timeout <= now))
+        {
+            _batch_slot_send(&_batch.slot[i]);
+        }
+    }
+
+    _batch_plan();
+
+    stats_task(STATS_TASK_BATCH, start);
+}
+
+static void _batch_slot_send(batch_slot_t *slot)
+{
+    if (slot->length == 0)
+    {
+        return;
+    }
+
+    usb_talk_message_start_id(&slot->id, "accelerometer/-/acceleration-batch");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("timestamp");
+
+    usb_talk_message_uint64(timesync_get(slot->timestamp));
+
+    usb_talk_message_key("offset");
+
+    usb_talk_message_array_begin();
+
+    for (int i = 0; i < slot->length; i++)
+    {
+        usb_talk_message_uint(slot->offset[i]);
+    }
+
+    usb_talk_message_array_end();
+
+    usb_talk_message_key("samples");
+
+    usb_talk_message_array_begin();
+
+    for (int i = 0; i < slot->length; i++)
+    {
+        usb_talk_message_array_begin();
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float *value = &slot->sample[i][axis];
+
+            usb_talk_message_float(value, precision_decimals(PRECISION_CLASS_ACCELERATION, value));
+        }
+
+        usb_talk_message_array_end();
+    }
+
+    usb_talk_message_array_end();
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+
+    slot->length = 0;
+}
+
+static void _batch_plan(void)
+{
+    twr_tick_t deadline = TWR_TICK_INFINITY;
+
+    for (int i = 0; i < BATCH_SLOT_COUNT; i++)
+    {
+        if ((_batch.slot[i].length != 0) && (_batch.slot[i].timestamp + _batch.timeout < deadline))
+        {
+            deadline = _batch.slot[i].timestamp + _batch.timeout;
+        }
+    }
+
+    twr_scheduler_plan_absolute(_batch.task_id, deadline);
+}
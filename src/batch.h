@@ -0,0 +1,26 @@
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <twr_common.h>
+
+#ifndef BATCH_SLOT_COUNT
+#define BATCH_SLOT_COUNT 4
+#endif
+#ifndef BATCH_SAMPLE_MAX
+#define BATCH_SAMPLE_MAX 16
+#endif
+#define BATCH_TIMEOUT_DEFAULT (1 * 1000)
+// Sample offsets are sent as 16 bit milliseconds
+#define BATCH_TIMEOUT_MAX (60 * 1000)
+
+void batch_init(void);
+
+void batch_set(int count, twr_tick_t timeout);
+
+void batch_get(int *count, twr_tick_t *timeout);
+
+bool batch_acceleration(uint64_t *id, float *x_axis, float *y_axis, float *z_axis);
+
+void batch_flush(void);
+
+#endif // _BATCH_H
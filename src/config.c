@@ -0,0 +1,405 @@
+#include <config.h>
+#include <eeprom.h>
+#include <usb_talk.h>
+#include <batch.h>
+#include <sensors.h>
+#include <precision.h>
+#include <crc.h>
+#include <stats.h>
+#include <twr_scheduler.h>
+#include <math.h>
+
+typedef struct
+{
+    const char *name;
+    config_type_t type;
+    config_value_t value;
+    config_value_t min;
+    config_value_t max;
+    // Value names of an enum, NULL terminated
+    const char *const *names;
+    // NULL when the value is only read where it is used
+    void (*apply)(void);
+
+} config_key_info_t;
+
+static void _config_apply_envelope(void);
+static void _config_apply_timestamp(void);
+static void _config_apply_buffer_format(void);
+static void _config_apply_batch(void);
+static void _config_apply_sensors(void);
+
+static const char *const _config_buffer_format_names[] = {
+    [USB_TALK_BUFFER_FORMAT_ARRAY] = "array",
+    [USB_TALK_BUFFER_FORMAT_BASE64] = "base64",
+    [USB_TALK_BUFFER_FORMAT_HEX] = "hex",
+    NULL
+};
+
+static const config_key_info_t _config_key_info[CONFIG_KEY_COUNT] = {
+    [CONFIG_KEY_ENVELOPE] = {"envelope", CONFIG_TYPE_BOOL, {.i = 0}, {.i = 0}, {.i = 1}, NULL, _config_apply_envelope},
+    [CONFIG_KEY_TIMESTAMP] = {"timestamp", CONFIG_TYPE_BOOL, {.i = 0}, {.i = 0}, {.i = 1}, NULL, _config_apply_timestamp},
+    [CONFIG_KEY_BUFFER_FORMAT] = {"buffer-format", CONFIG_TYPE_ENUM, {.i = USB_TALK_BUFFER_FORMAT}, {.i = USB_TALK_BUFFER_FORMAT_ARRAY}, {.i = USB_TALK_BUFFER_FORMAT_HEX}, _config_buffer_format_names, _config_apply_buffer_format},
+    [CONFIG_KEY_BATCH_COUNT] = {"batch-count", CONFIG_TYPE_INT, {.i = 0}, {.i = 0}, {.i = BATCH_SAMPLE_MAX}, NULL, _config_apply_batch},
+    [CONFIG_KEY_BATCH_TIMEOUT] = {"batch-timeout", CONFIG_TYPE_INT, {.i = BATCH_TIMEOUT_DEFAULT}, {.i = 0}, {.i = BATCH_TIMEOUT_MAX}, NULL, _config_apply_batch},
+    [CONFIG_KEY_TEMPERATURE_INTERVAL] = {"temperature-interval", CONFIG_TYPE_INT, {.i = TEMPERATURE_TAG_UPDATE_INTERVAL}, {.i = SENSORS_BURST_PERIOD}, {.i = SENSORS_INTERVAL_MAX}, NULL, _config_apply_sensors},
+    [CONFIG_KEY_TEMPERATURE_CHANGE] = {"temperature-change", CONFIG_TYPE_FLOAT, {.f = TEMPERATURE_TAG_PUB_VALUE_CHANGE}, {.f = 0.f}, {.f = 100.f}, NULL, NULL},
+    [CONFIG_KEY_TEMPERATURE_NO_CHANGE_INTERVAL] = {"temperature-no-change-interval", CONFIG_TYPE_INT, {.i = TEMPERATURE_TAG_PUB_NO_CHANGE_INTEVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_INTERVAL] = {"humidity-interval", CONFIG_TYPE_INT, {.i = HUMIDITY_TAG_UPDATE_INTERVAL}, {.i = SENSORS_BURST_PERIOD}, {.i = SENSORS_INTERVAL_MAX}, NULL, _config_apply_sensors},
+    [CONFIG_KEY_HUMIDITY_CHANGE] = {"humidity-change", CONFIG_TYPE_FLOAT, {.f = HUMIDITY_TAG_PUB_VALUE_CHANGE}, {.f = 0.f}, {.f = 100.f}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_NO_CHANGE_INTERVAL] = {"humidity-no-change-interval", CONFIG_TYPE_INT, {.i = HUMIDITY_TAG_PUB_NO_CHANGE_INTEVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_INTERVAL] = {"lux-meter-interval", CONFIG_TYPE_INT, {.i = LUX_METER_TAG_UPDATE_INTERVAL}, {.i = SENSORS_BURST_PERIOD}, {.i = SENSORS_INTERVAL_MAX}, NULL, _config_apply_sensors},
+    [CONFIG_KEY_LUX_METER_CHANGE] = {"lux-meter-change", CONFIG_TYPE_FLOAT, {.f = LUX_METER_TAG_PUB_VALUE_CHANGE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_NO_CHANGE_INTERVAL] = {"lux-meter-no-change-interval", CONFIG_TYPE_INT, {.i = LUX_METER_TAG_PUB_NO_CHANGE_INTEVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_INTERVAL] = {"barometer-interval", CONFIG_TYPE_INT, {.i = BAROMETER_TAG_UPDATE_INTERVAL}, {.i = SENSORS_BURST_PERIOD}, {.i = SENSORS_INTERVAL_MAX}, NULL, _config_apply_sensors},
+    [CONFIG_KEY_BAROMETER_CHANGE] = {"barometer-change", CONFIG_TYPE_FLOAT, {.f = BAROMETER_TAG_PUB_VALUE_CHANGE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_NO_CHANGE_INTERVAL] = {"barometer-no-change-interval", CONFIG_TYPE_INT, {.i = BAROMETER_TAG_PUB_NO_CHANGE_INTEVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_CO2_INTERVAL] = {"co2-interval", CONFIG_TYPE_INT, {.i = CO2_UPDATE_INTERVAL}, {.i = CO2_UPDATE_INTERVAL_MIN}, {.i = SENSORS_INTERVAL_MAX}, NULL, _config_apply_sensors},
+    [CONFIG_KEY_CO2_CHANGE] = {"co2-change", CONFIG_TYPE_FLOAT, {.f = CO2_PUB_VALUE_CHANGE}, {.f = 0.f}, {.f = 10000.f}, NULL, NULL},
+    [CONFIG_KEY_CO2_NO_CHANGE_INTERVAL] = {"co2-no-change-interval", CONFIG_TYPE_INT, {.i = CO2_PUB_NO_CHANGE_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_TEMPERATURE_SMOOTHING] = {"temperature-smoothing", CONFIG_TYPE_FLOAT, {.f = TEMPERATURE_TAG_PUB_SMOOTHING}, {.f = 0.01f}, {.f = 1.f}, NULL, NULL},
+    [CONFIG_KEY_TEMPERATURE_HYSTERESIS] = {"temperature-hysteresis", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_HYSTERESIS}, {.f = 0.f}, {.f = 10.f}, NULL, NULL},
+    [CONFIG_KEY_TEMPERATURE_RATE] = {"temperature-rate", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_RATE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_TEMPERATURE_MIN_INTERVAL] = {"temperature-min-interval", CONFIG_TYPE_INT, {.i = TEMPERATURE_TAG_PUB_MIN_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_SMOOTHING] = {"humidity-smoothing", CONFIG_TYPE_FLOAT, {.f = HUMIDITY_TAG_PUB_SMOOTHING}, {.f = 0.01f}, {.f = 1.f}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_HYSTERESIS] = {"humidity-hysteresis", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_HYSTERESIS}, {.f = 0.f}, {.f = 10.f}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_RATE] = {"humidity-rate", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_RATE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_HUMIDITY_MIN_INTERVAL] = {"humidity-min-interval", CONFIG_TYPE_INT, {.i = HUMIDITY_TAG_PUB_MIN_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_SMOOTHING] = {"lux-meter-smoothing", CONFIG_TYPE_FLOAT, {.f = LUX_METER_TAG_PUB_SMOOTHING}, {.f = 0.01f}, {.f = 1.f}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_HYSTERESIS] = {"lux-meter-hysteresis", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_HYSTERESIS}, {.f = 0.f}, {.f = 10.f}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_RATE] = {"lux-meter-rate", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_RATE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_LUX_METER_MIN_INTERVAL] = {"lux-meter-min-interval", CONFIG_TYPE_INT, {.i = LUX_METER_TAG_PUB_MIN_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_SMOOTHING] = {"barometer-smoothing", CONFIG_TYPE_FLOAT, {.f = BAROMETER_TAG_PUB_SMOOTHING}, {.f = 0.01f}, {.f = 1.f}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_HYSTERESIS] = {"barometer-hysteresis", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_HYSTERESIS}, {.f = 0.f}, {.f = 10.f}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_RATE] = {"barometer-rate", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_RATE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_BAROMETER_MIN_INTERVAL] = {"barometer-min-interval", CONFIG_TYPE_INT, {.i = BAROMETER_TAG_PUB_MIN_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL},
+    [CONFIG_KEY_CO2_SMOOTHING] = {"co2-smoothing", CONFIG_TYPE_FLOAT, {.f = CO2_PUB_SMOOTHING}, {.f = 0.01f}, {.f = 1.f}, NULL, NULL},
+    [CONFIG_KEY_CO2_HYSTERESIS] = {"co2-hysteresis", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_HYSTERESIS}, {.f = 0.f}, {.f = 10.f}, NULL, NULL},
+    [CONFIG_KEY_CO2_RATE] = {"co2-rate", CONFIG_TYPE_FLOAT, {.f = SENSORS_PUB_RATE}, {.f = 0.f}, {.f = 100000.f}, NULL, NULL},
+    [CONFIG_KEY_CO2_MIN_INTERVAL] = {"co2-min-interval", CONFIG_TYPE_INT, {.i = CO2_PUB_MIN_INTERVAL}, {.i = 0}, {.i = SENSORS_NO_CHANGE_INTERVAL_MAX}, NULL, NULL}
+};
+
+static struct
+{
+    // Hot paths read this copy only
+    config_value_t value[CONFIG_KEY_COUNT];
+    // What EEPROM holds, or the default while the slot is blank
+    config_value_t stored[CONFIG_KEY_COUNT];
+
+    bool pending;
+
+    twr_scheduler_task_id_t task_id;
+
+} _config;
+
+_Static_assert(EEPROM_CONFIG_ADDRESS + (CONFIG_KEY_COUNT * sizeof(config_slot_t)) <= EEPROM_RADIO_ADDRESS, "config slots overlap the radio peer table");
+
+static void _config_task(void *param);
+static bool _config_set(config_key_t key, config_value_t value);
+static bool _config_is_valid(config_key_t key, config_value_t value);
+static uint16_t _config_slot_crc(config_slot_t *slot);
+static void _config_message_value(config_key_t key);
+
+void config_init(void)
+{
+    memset(&_config, 0, sizeof(_config));
+
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++)
+    {
+        config_slot_t slot;
+
+        _config.value[i] = _config_key_info[i].value;
+
+        // Blank, torn or from a build where the key had another type, the default stays
+        if (twr_eeprom_read(EEPROM_CONFIG_ADDRESS + (i * sizeof(config_slot_t)), &slot, sizeof(slot)) &&
+            (slot.key == i) && (slot.type == _config_key_info[i].type) && (slot.crc == _config_slot_crc(&slot)) &&
+            _config_is_valid(i, slot.value))
+        {
+            _config.value[i] = slot.value;
+        }
+
+        _config.stored[i] = _config.value[i];
+    }
+
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++)
+    {
+        // Keys sharing a setter apply it more than once, harmless at boot
+        if (_config_key_info[i].apply != NULL)
+        {
+            _config_key_info[i].apply();
+        }
+    }
+
+    _config.task_id = twr_scheduler_register(_config_task, NULL, TWR_TICK_INFINITY);
+}
+
+bool config_find(const char *name, config_key_t *key)
+{
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++)
+    {
+        if (strcmp(_config_key_info[i].name, name) == 0)
+        {
+            *key = i;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+config_type_t config_get_type(config_key_t key)
+{
+    return _config_key_info[key].type;
+}
+
+bool config_get_bool(config_key_t key)
+{
+    return _config.value[key].i != 0;
+}
+
+int32_t config_get_int(config_key_t key)
+{
+    return _config.value[key].i;
+}
+
+float config_get_float(config_key_t key)
+{
+    return _config.value[key].f;
+}
+
+bool config_set_bool(config_key_t key, bool value)
+{
+    if (_config_key_info[key].type != CONFIG_TYPE_BOOL)
+    {
+        return false;
+    }
+
+    return _config_set(key, (config_value_t) {.i = value ? 1 : 0});
+}
+
+bool config_set_int(config_key_t key, int32_t value)
+{
+    if ((_config_key_info[key].type != CONFIG_TYPE_INT) && (_config_key_info[key].type != CONFIG_TYPE_ENUM))
+    {
+        return false;
+    }
+
+    return _config_set(key, (config_value_t) {.i = value});
+}
+
+bool config_set_float(config_key_t key, float value)
+{
+    if (_config_key_info[key].type != CONFIG_TYPE_FLOAT)
+    {
+        return false;
+    }
+
+    return _config_set(key, (config_value_t) {.f = value});
+}
+
+bool config_set_enum(config_key_t key, const char *name)
+{
+    if (_config_key_info[key].type != CONFIG_TYPE_ENUM)
+    {
+        return false;
+    }
+
+    for (int i = 0; _config_key_info[key].names[i] != NULL; i++)
+    {
+        if (strcmp(_config_key_info[key].names[i], name) == 0)
+        {
+            return _config_set(key, (config_value_t) {.i = i});
+        }
+    }
+
+    return false;
+}
+
+void config_send(config_key_t key)
+{
+    usb_talk_message_start("$config/%s", _config_key_info[key].name);
+
+    _config_message_value(key);
+
+    usb_talk_message_send();
+}
+
+void config_list(int page)
+{
+    if ((page < 0) || (page * CONFIG_LIST_ON_PAGE >= CONFIG_KEY_COUNT))
+    {
+        return;
+    }
+
+    int max_i = (page + 1) * CONFIG_LIST_ON_PAGE;
+
+    if (max_i > CONFIG_KEY_COUNT)
+    {
+        max_i = CONFIG_KEY_COUNT;
+    }
+
+    usb_talk_message_start("$config/list/%d", page);
+
+    usb_talk_message_object_begin();
+
+    for (int i = page * CONFIG_LIST_ON_PAGE; i < max_i; i++)
+    {
+        usb_talk_message_key(_config_key_info[i].name);
+
+        _config_message_value(i);
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+static void _config_task(void *param)
+{
+    (void) param;
+
+    stats_mark_t start = stats_mark();
+
+    _config.pending = false;
+
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++)
+    {
+        // Set and set back within the window costs nothing
+        if (_config.value[i].i == _config.stored[i].i)
+        {
+            continue;
+        }
+
+        config_slot_t slot = {
+            .key = i,
+            .type = _config_key_info[i].type,
+            .value = _config.value[i]
+        };
+
+        slot.crc = _config_slot_crc(&slot);
+
+        if (!twr_eeprom_write(EEPROM_CONFIG_ADDRESS + (i * sizeof(config_slot_t)), &slot, sizeof(slot)))
+        {
+            // Try again later, RAM keeps the value meanwhile
+            _config.pending = true;
+
+            continue;
+        }
+
+        _config.stored[i] = slot.value;
+    }
+
+    if (_config.pending)
+    {
+        twr_scheduler_plan_current_relative(CONFIG_FLUSH_DELAY);
+    }
+
+    stats_task(STATS_TASK_CONFIG, start);
+}
+
+static bool _config_set(config_key_t key, config_value_t value)
+{
+    if (!_config_is_valid(key, value))
+    {
+        return false;
+    }
+
+    _config.value[key] = value;
+
+    if (_config_key_info[key].apply != NULL)
+    {
+        _config_key_info[key].apply();
+    }
+
+    if (!_config.pending && (_config.value[key].i != _config.stored[key].i))
+    {
+        // Planned from the first change, a stream of changes does not hold the write off
+        twr_scheduler_plan_relative(_config.task_id, CONFIG_FLUSH_DELAY);
+
+        _config.pending = true;
+    }
+
+    return true;
+}
+
+static bool _config_is_valid(config_key_t key, config_value_t value)
+{
+    const config_key_info_t *info = &_config_key_info[key];
+
+    if (info->type == CONFIG_TYPE_FLOAT)
+    {
+        return !isnan(value.f) && (value.f >= info->min.f) && (value.f <= info->max.f);
+    }
+
+    return (value.i >= info->min.i) && (value.i <= info->max.i);
+}
+
+static uint16_t _config_slot_crc(config_slot_t *slot)
+{
+    uint16_t crc = crc16(CRC16_INIT, slot, offsetof(config_slot_t, crc));
+
+    return crc16(crc, &slot->value, sizeof(slot->value));
+}
+
+static void _config_message_value(config_key_t key)
+{
+    switch (_config_key_info[key].type)
+    {
+        case CONFIG_TYPE_BOOL:
+        {
+            usb_talk_message_bool(_config.value[key].i != 0);
+
+            break;
+        }
+        case CONFIG_TYPE_INT:
+        {
+            usb_talk_message_int(_config.value[key].i);
+
+            break;
+        }
+        case CONFIG_TYPE_FLOAT:
+        {
+            usb_talk_message_float(&_config.value[key].f, precision_decimals(PRECISION_CLASS_FLOAT, &_config.value[key].f));
+
+            break;
+        }
+        case CONFIG_TYPE_ENUM:
+        {
+            usb_talk_message_string(_config_key_info[key].names[_config.value[key].i]);
+
+            break;
+        }
+        default:
+        {
+            usb_talk_message_null();
+
+            break;
+        }
+    }
+}
+
+static void _config_apply_envelope(void)
+{
+    usb_talk_set_envelope(config_get_bool(CONFIG_KEY_ENVELOPE));
+}
+
+static void _config_apply_timestamp(void)
+{
+    usb_talk_set_timestamp(config_get_bool(CONFIG_KEY_TIMESTAMP));
+}
+
+static void _config_apply_buffer_format(void)
+{
+    usb_talk_set_buffer_format((usb_talk_buffer_format_t) config_get_int(CONFIG_KEY_BUFFER_FORMAT));
+}
+
+static void _config_apply_batch(void)
+{
+    batch_set(config_get_int(CONFIG_KEY_BATCH_COUNT), config_get_int(CONFIG_KEY_BATCH_TIMEOUT));
+}
+
+static void _config_apply_sensors(void)
+{
+    sensors_update_intervals();
+}
@@ -0,0 +1,112 @@
+#ifndef _CONFIG_H
+#define _CONFIG_H
+
+#include <twr_common.h>
+
+// Changes are written this long after the first one, later ones within the window go along
+#ifndef CONFIG_FLUSH_DELAY
+#define CONFIG_FLUSH_DELAY (10 * 1000)
+#endif
+
+// Keys in one list message, all of them at once do not fit the transmit buffer
+#define CONFIG_LIST_ON_PAGE 8
+
+typedef enum
+{
+    CONFIG_TYPE_BOOL = 0,
+    CONFIG_TYPE_INT = 1,
+    CONFIG_TYPE_FLOAT = 2,
+    // Stored as int, listed by name, set by name or index
+    CONFIG_TYPE_ENUM = 3
+
+} config_type_t;
+
+// The key is the slot in EEPROM, append new keys only
+typedef enum
+{
+    CONFIG_KEY_ENVELOPE = 0,
+    CONFIG_KEY_TIMESTAMP = 1,
+    CONFIG_KEY_BUFFER_FORMAT = 2,
+    CONFIG_KEY_BATCH_COUNT = 3,
+    CONFIG_KEY_BATCH_TIMEOUT = 4,
+    CONFIG_KEY_TEMPERATURE_INTERVAL = 5,
+    CONFIG_KEY_TEMPERATURE_CHANGE = 6,
+    CONFIG_KEY_TEMPERATURE_NO_CHANGE_INTERVAL = 7,
+    CONFIG_KEY_HUMIDITY_INTERVAL = 8,
+    CONFIG_KEY_HUMIDITY_CHANGE = 9,
+    CONFIG_KEY_HUMIDITY_NO_CHANGE_INTERVAL = 10,
+    CONFIG_KEY_LUX_METER_INTERVAL = 11,
+    CONFIG_KEY_LUX_METER_CHANGE = 12,
+    CONFIG_KEY_LUX_METER_NO_CHANGE_INTERVAL = 13,
+    CONFIG_KEY_BAROMETER_INTERVAL = 14,
+    CONFIG_KEY_BAROMETER_CHANGE = 15,
+    CONFIG_KEY_BAROMETER_NO_CHANGE_INTERVAL = 16,
+    CONFIG_KEY_CO2_INTERVAL = 17,
+    CONFIG_KEY_CO2_CHANGE = 18,
+    CONFIG_KEY_CO2_NO_CHANGE_INTERVAL = 19,
+    CONFIG_KEY_TEMPERATURE_SMOOTHING = 20,
+    CONFIG_KEY_TEMPERATURE_HYSTERESIS = 21,
+    CONFIG_KEY_TEMPERATURE_RATE = 22,
+    CONFIG_KEY_TEMPERATURE_MIN_INTERVAL = 23,
+    CONFIG_KEY_HUMIDITY_SMOOTHING = 24,
+    CONFIG_KEY_HUMIDITY_HYSTERESIS = 25,
+    CONFIG_KEY_HUMIDITY_RATE = 26,
+    CONFIG_KEY_HUMIDITY_MIN_INTERVAL = 27,
+    CONFIG_KEY_LUX_METER_SMOOTHING = 28,
+    CONFIG_KEY_LUX_METER_HYSTERESIS = 29,
+    CONFIG_KEY_LUX_METER_RATE = 30,
+    CONFIG_KEY_LUX_METER_MIN_INTERVAL = 31,
+    CONFIG_KEY_BAROMETER_SMOOTHING = 32,
+    CONFIG_KEY_BAROMETER_HYSTERESIS = 33,
+    CONFIG_KEY_BAROMETER_RATE = 34,
+    CONFIG_KEY_BAROMETER_MIN_INTERVAL = 35,
+    CONFIG_KEY_CO2_SMOOTHING = 36,
+    CONFIG_KEY_CO2_HYSTERESIS = 37,
+    CONFIG_KEY_CO2_RATE = 38,
+    CONFIG_KEY_CO2_MIN_INTERVAL = 39,
+
+    CONFIG_KEY_COUNT = 40
+
+} config_key_t;
+
+typedef union
+{
+    int32_t i;
+    float f;
+
+} config_value_t;
+
+typedef struct
+{
+    uint8_t key;
+    uint8_t type;
+    uint16_t crc;
+    config_value_t value;
+
+} config_slot_t;
+
+void config_init(void);
+
+bool config_find(const char *name, config_key_t *key);
+
+config_type_t config_get_type(config_key_t key);
+
+bool config_get_bool(config_key_t key);
+
+int32_t config_get_int(config_key_t key);
+
+float config_get_float(config_key_t key);
+
+bool config_set_bool(config_key_t key, bool value);
+
+bool config_set_int(config_key_t key, int32_t value);
+
+bool config_set_float(config_key_t key, float value);
+
+bool config_set_enum(config_key_t key, const char *name);
+
+void config_send(config_key_t key);
+
+void config_list(int page);
+
+#endif // _CONFIG_H
@@ -0,0 +1,11 @@
+#ifndef _CRC_H
+#define _CRC_H
+
+#include <twr_common.h>
+
+// CRC-16/CCITT-FALSE, polynomial 0x1021, no reflection, no final xor
+#define CRC16_INIT 0xffff
+
+uint16_t crc16(uint16_t crc, const void *buffer, size_t length);
+
+#endif // _CRC_H
@@ -0,0 +1,288 @@
+#include <deadband.h>
+#include <usb_talk.h>
+#include <math.h>
+
+typedef struct
+{
+    // Hash of the topic, zero marks an empty entry
+    uint32_t key;
+
+    // Compared along with the key, a hash alone could put two nodes on one entry
+    uint64_t id;
+
+    union
+    {
+        float f;
+        int32_t i;
+
+    } value;
+
+    twr_tick_t next_pub;
+
+} deadband_entry_t;
+
+static struct
+{
+    struct
+    {
+        float change;
+        // Zero turns the class off
+        twr_tick_t interval;
+
+        uint32_t passed;
+        uint32_t suppressed;
+
+    } config[DEADBAND_CLASS_COUNT];
+
+    deadband_entry_t entry[DEADBAND_LENGTH];
+
+} _deadband;
+
+static const char *_deadband_class_get_name(int deadband_class);
+static deadband_entry_t *_deadband_entry(int deadband_class, uint64_t *id, const char *topic, bool *found);
+static bool _deadband_pass(int deadband_class, deadband_entry_t *entry, bool changed);
+
+bool deadband_float(uint64_t *id, const char *topic, float *value)
+{
+    if (value == NULL)
+    {
+        return true;
+    }
+
+    int deadband_class = precision_class_find(topic);
+
+    bool found;
+
+    deadband_entry_t *entry = _deadband_entry(deadband_class, id, topic, &found);
+
+    if (entry == NULL)
+    {
+        return true;
+    }
+
+    float difference = fabsf(*value - entry->value.f);
+
+    // Same test as the sensors, exact repeats are always dropped, NaN counts as a change
+    bool changed = !found || ((difference != 0.f) && !(difference < _deadband.config[deadband_class].change));
+
+    if (!_deadband_pass(deadband_class, entry, changed))
+    {
+        return false;
+    }
+
+    entry->value.f = *value;
+
+    return true;
+}
+
+bool deadband_int(uint64_t *id, const char *topic, int *value)
+{
+    if (value == NULL)
+    {
+        return true;
+    }
+
+    bool found;
+
+    deadband_entry_t *entry = _deadband_entry(DEADBAND_CLASS_INT, id, topic, &found);
+
+    if (entry == NULL)
+    {
+        return true;
+    }
+
+    float difference = fabsf((float) *value - (float) entry->value.i);
+
+    bool changed = !found || ((*value != entry->value.i) && !(difference < _deadband.config[DEADBAND_CLASS_INT].change));
+
+    if (!_deadband_pass(DEADBAND_CLASS_INT, entry, changed))
+    {
+        return false;
+    }
+
+    entry->value.i = *value;
+
+    return true;
+}
+
+bool deadband_bool(uint64_t *id, const char *topic, bool *value)
+{
+    if (value == NULL)
+    {
+        return true;
+    }
+
+    bool found;
+
+    deadband_entry_t *entry = _deadband_entry(DEADBAND_CLASS_BOOL, id, topic, &found);
+
+    if (entry == NULL)
+    {
+        return true;
+    }
+
+    bool changed = !found || (*value != (entry->value.i != 0));
+
+    if (!_deadband_pass(DEADBAND_CLASS_BOOL, entry, changed))
+    {
+        return false;
+    }
+
+    entry->value.i = *value;
+
+    return true;
+}
+
+bool deadband_set(const char *name, float change, twr_tick_t interval)
+{
+    for (int i = 0; i < DEADBAND_CLASS_COUNT; i++)
+    {
+        if (strcmp(_deadband_class_get_name(i), name) != 0)
+        {
+            continue;
+        }
+
+        _deadband.config[i].change = change < 0.f ? 0.f : change;
+        _deadband.config[i].interval = interval;
+        _deadband.config[i].passed = 0;
+        _deadband.config[i].suppressed = 0;
+
+        // Entries of the class may hold values from before, start over
+        memset(_deadband.entry, 0, sizeof(_deadband.entry));
+
+        return true;
+    }
+
+    return false;
+}
+
+void deadband_list(void)
+{
+    usb_talk_message_start("/deadband");
+
+    usb_talk_message_object_begin();
+
+    for (int i = 0; i < DEADBAND_CLASS_COUNT; i++)
+    {
+        if (_deadband.config[i].interval == 0)
+        {
+            continue;
+        }
+
+        usb_talk_message_key(_deadband_class_get_name(i));
+
+        usb_talk_message_object_begin();
+
+        if (i < PRECISION_CLASS_COUNT)
+        {
+            usb_talk_message_key("change");
+
+            usb_talk_message_float(&_deadband.config[i].change, precision_decimals(i, &_deadband.config[i].change));
+        }
+        else if (i == DEADBAND_CLASS_INT)
+        {
+            usb_talk_message_key("change");
+
+            usb_talk_message_uint((uint32_t) _deadband.config[i].change);
+        }
+
+        usb_talk_message_key("interval");
+
+        usb_talk_message_uint(_deadband.config[i].interval);
+
+        usb_talk_message_key("passed");
+
+        usb_talk_message_uint(_deadband.config[i].passed);
+
+        usb_talk_message_key("suppressed");
+
+        usb_talk_message_uint(_deadband.config[i].suppressed);
+
+        usb_talk_message_object_end();
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+static const char *_deadband_class_get_name(int deadband_class)
+{
+    if (deadband_class == DEADBAND_CLASS_INT)
+    {
+        return "int";
+    }
+    else if (deadband_class == DEADBAND_CLASS_BOOL)
+    {
+        return "bool";
+    }
+
+    return precision_class_get_name(deadband_class);
+}
+
+static deadband_entry_t *_deadband_entry(int deadband_class, uint64_t *id, const char *topic, bool *found)
+{
+    if (_deadband.config[deadband_class].interval == 0)
+    {
+        return NULL;
+    }
+
+    // FNV-1a
+    uint32_t key = 2166136261u;
+
+    for (const char *c = topic; *c != '\0'; c++)
+    {
+        key ^= (uint8_t) *c;
+
+        key *= 16777619u;
+    }
+
+    if (key == 0)
+    {
+        key = 1;
+    }
+
+    deadband_entry_t *oldest = &_deadband.entry[0];
+
+    for (int i = 0; i < DEADBAND_LENGTH; i++)
+    {
+        if ((_deadband.entry[i].key == key) && (_deadband.entry[i].id == *id))
+        {
+            *found = true;
+
+            return &_deadband.entry[i];
+        }
+
+        // Empty entries have next_pub zero so they are taken first
+        if (_deadband.entry[i].next_pub < oldest->next_pub)
+        {
+            oldest = &_deadband.entry[i];
+        }
+    }
+
+    *found = false;
+
+    oldest->key = key;
+
+    oldest->id = *id;
+
+    return oldest;
+}
+
+static bool _deadband_pass(int deadband_class, deadband_entry_t *entry, bool changed)
+{
+    twr_tick_t now = twr_tick_get();
+
+    if (!changed && (entry->next_pub > now))
+    {
+        _deadband.config[deadband_class].suppressed++;
+
+        return false;
+    }
+
+    _deadband.config[deadband_class].passed++;
+
+    entry->next_pub = now + _deadband.config[deadband_class].interval;
+
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef _DEADBAND_H
+#define _DEADBAND_H
+
+#include <twr_common.h>
+#include <precision.h>
+
+#ifndef DEADBAND_LENGTH
+#define DEADBAND_LENGTH 32
+#endif
+#define DEADBAND_INTERVAL_DEFAULT (5 * 60 * 1000)
+
+// Float values use the precision classes, integers and booleans have their own
+#define DEADBAND_CLASS_INT PRECISION_CLASS_COUNT
+#define DEADBAND_CLASS_BOOL (PRECISION_CLASS_COUNT + 1)
+#define DEADBAND_CLASS_COUNT (PRECISION_CLASS_COUNT + 2)
+
+bool deadband_float(uint64_t *id, const char *topic, float *value);
+
+bool deadband_int(uint64_t *id, const char *topic, int *value);
+
+bool deadband_bool(uint64_t *id, const char *topic, bool *value);
+
+bool deadband_set(const char *name, float change, twr_tick_t interval);
+
+void deadband_list(void);
+
+#endif // _DEADBAND_H
@@ -1,222 +1,1073 @@
 #include <eeprom.h>
 #include <usb_talk.h>
 #include <twr_radio.h>
+#include <crc.h>
+#include <twr_scheduler.h>
 
 static struct
 {
     uint8_t alias_length;
 
-    uint8_t buffer[EEPROM_ALIAS_ROW_LENGTH + 1];
+    // Copy of the ID column
+    uint64_t alias_id[EEPROM_ALIAS_MAX];
+
+    // Latest set record of each alias, or the legacy row while migrating
+    uint16_t alias_address[EEPROM_ALIAS_MAX];
+    uint8_t alias_name_length[EEPROM_ALIAS_MAX];
+    uint16_t alias_name_hash[EEPROM_ALIAS_MAX];
+
+    // Bytes the live records take after a compaction
+    size_t alias_size;
+
+    // Row number plus one by ID hash and by name hash, zero is an empty slot
+    uint8_t alias_index[EEPROM_ALIAS_INDEX_LENGTH];
+    uint8_t alias_name_index[EEPROM_ALIAS_INDEX_LENGTH];
+
+    // Log half in use, its generation and where the next record goes
+    int half;
+    uint32_t generation;
+    uint32_t end;
+    uint16_t sequence;
+
+    bool legacy;
+
+    // Open bulk set, where it started and the records left
+    bool transaction;
+    uint32_t transaction_start;
+    uint16_t transaction_sequence;
+    int transaction_left;
+    int transaction_new;
+    size_t transaction_size;
+
+    // Record of add, stage, compaction and listing, with the name zero terminated for sending
+    eeprom_alias_record_t record;
+    char name[EEPROM_ALIAS_NAME_LENGTH + 1];
+
+    // Dump in progress, next chunk to send
+    twr_scheduler_task_id_t dump_task_id;
+    int dump_chunk;
 
 } _eeprom;
 
 static int _eeprom_alias_find_position_for_id(uint64_t *id);
-static bool _eeprom_alias_length_set(uint8_t length);
+static void _eeprom_alias_index_build(void);
+static uint32_t _eeprom_alias_index_hash(uint64_t *id);
+static uint16_t _eeprom_alias_name_hash(const char *name, size_t length);
+static bool _eeprom_alias_load(void);
+static bool _eeprom_alias_legacy_load(void);
+static bool _eeprom_alias_header_read(int half, uint32_t *generation);
+static bool _eeprom_alias_header_write(int half, uint32_t generation);
+static size_t _eeprom_alias_record_size(eeprom_alias_record_t *record);
+static size_t _eeprom_alias_record_size_for(size_t name_length);
+static bool _eeprom_alias_name_equal(int i, const char *name, size_t name_length);
+static bool _eeprom_alias_fits(int i, size_t name_length, size_t *size);
+static bool _eeprom_alias_record_read(uint32_t address, eeprom_alias_record_t *record);
+static uint16_t _eeprom_alias_record_crc(uint32_t generation, eeprom_alias_record_t *record);
+static uint32_t _eeprom_alias_half_end(void);
+static bool _eeprom_alias_reserve(size_t size);
+static bool _eeprom_alias_append(eeprom_alias_record_t *record);
+static bool _eeprom_alias_compact(void);
+static bool _eeprom_alias_remove(uint64_t *id);
+static void _eeprom_alias_forget(int i);
+static void _eeprom_alias_apply(uint32_t address, eeprom_alias_record_t *record);
+static void _eeprom_alias_apply_pending(uint32_t address, uint32_t end, eeprom_alias_record_t *record);
+static void _eeprom_alias_chunk_send(const char *topic, int chunk);
+static void _eeprom_alias_dump_task(void *param);
 
 void eeprom_init(void)
 {
     memset(&_eeprom, 0, sizeof(_eeprom));
 
-    uint8_t buffer[2];
-
-    twr_eeprom_read(EEPROM_ALIAS_ADDRESS_LENGTH, buffer, sizeof(buffer));
+    _eeprom.dump_task_id = twr_scheduler_register(_eeprom_alias_dump_task, NULL, TWR_TICK_INFINITY);
 
-    uint8_t neg = ~buffer[1];
+    bool compact = false;
 
-    if (buffer[0] == neg)
+    if (!_eeprom_alias_load())
     {
-        _eeprom.alias_length = buffer[0];
+        if (_eeprom_alias_legacy_load())
+        {
+            // Legacy rows sit in the first half, marked full the log starts in the second one
+            _eeprom.half = 0;
+            _eeprom.end = _eeprom_alias_half_end();
+
+            compact = true;
+        }
+        else
+        {
+            _eeprom.alias_length = 0;
+
+            _eeprom_alias_header_write(0, 1);
+
+            _eeprom_alias_load();
+        }
     }
 
-    // Remove alias for unknown nodes
-    uint32_t address = EEPROM_ALIAS_ADDRESS_START;
+    // Alias for unknown nodes go, first size up what they take
+    eeprom_alias_record_t record;
+
+    memset(&record, 0, sizeof(record));
 
-    uint64_t tmp_id;
+    record.type = EEPROM_ALIAS_RECORD_REMOVE;
 
-    uint64_t id_on_remove;
+    size_t stale_size = 0;
+    size_t live_size = _eeprom.alias_size;
 
-    while (true)
+    for (int i = 0; i < _eeprom.alias_length; i++)
     {
-        id_on_remove = 0;
+        if (!twr_radio_is_peer_device(_eeprom.alias_id[i]))
+        {
+            stale_size += _eeprom_alias_record_size(&record);
+            live_size -= _eeprom_alias_record_size_for(_eeprom.alias_name_length[i]);
+        }
+    }
 
-        for (int i = 0; i < _eeprom.alias_length; i++)
+    // Short remove records unless one compaction writes less, as when most nodes are gone or the half is full
+    bool append = !compact && (stale_size < live_size) && (_eeprom.end + stale_size <= _eeprom_alias_half_end());
+
+    bool failed = false;
+
+    int length = 0;
+
+    // One pass over the rows, the index is built once at the end
+    for (int i = 0; i < _eeprom.alias_length; i++)
+    {
+        if (!twr_radio_is_peer_device(_eeprom.alias_id[i]))
         {
-            twr_eeprom_read(address, &tmp_id, sizeof(tmp_id));
+            // Dropped here, the compaction below writes the rest out
+            if (!append)
+            {
+                continue;
+            }
+
+            record.id = _eeprom.alias_id[i];
 
-            if (!twr_radio_is_peer_device(tmp_id))
+            if (!failed && _eeprom_alias_append(&record))
             {
-                id_on_remove = tmp_id;
+                _eeprom.alias_size -= _eeprom_alias_record_size_for(_eeprom.alias_name_length[i]);
 
-                break;
+                continue;
             }
 
-            address += EEPROM_ALIAS_ROW_LENGTH;
+            // Kept until the next boot
+            failed = true;
         }
 
-        if (id_on_remove != 0)
+        _eeprom.alias_id[length] = _eeprom.alias_id[i];
+        _eeprom.alias_address[length] = _eeprom.alias_address[i];
+        _eeprom.alias_name_length[length] = _eeprom.alias_name_length[i];
+        _eeprom.alias_name_hash[length] = _eeprom.alias_name_hash[i];
+
+        length++;
+    }
+
+    if (length != _eeprom.alias_length)
+    {
+        _eeprom.alias_length = length;
+
+        if (append)
         {
-            eeprom_alias_remove(&id_on_remove);
+            _eeprom_alias_index_build();
         }
         else
         {
-            break;
+            compact = true;
         }
     }
+
+    if (compact)
+    {
+        // On failure the stale rows are read back, the next boot retries
+        _eeprom_alias_compact();
+    }
 }
 
 void eeprom_alias_add(uint64_t *id, char *name)
 {
     int i = _eeprom_alias_find_position_for_id(id);
 
-    if (i == -1)
+    size_t name_length = strnlen(name, EEPROM_ALIAS_NAME_LENGTH);
+
+    // Same name again, nothing to write
+    if ((i != -1) && _eeprom_alias_name_equal(i, name, name_length))
     {
-        i = _eeprom.alias_length;
+        usb_talk_send_format("[\"$eeprom/alias/add/ok\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+
+        return;
     }
 
-    uint32_t address = EEPROM_ALIAS_ADDRESS_START + (i * EEPROM_ALIAS_ROW_LENGTH);
+    if ((i == -1) && (_eeprom.alias_length >= EEPROM_ALIAS_MAX))
+    {
+        usb_talk_send_format("[\"$eeprom/alias/add/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+
+        return;
+    }
 
-    uint64_t *pid = (uint64_t *)_eeprom.buffer;
+    size_t alias_size = _eeprom.alias_size;
 
-    *pid = *id;
+    if (!_eeprom_alias_fits(i, name_length, &alias_size))
+    {
+        usb_talk_send_format("[\"$eeprom/alias/add/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
 
-    memcpy(_eeprom.buffer + 8, name, 32);
+        return;
+    }
 
-    if (!twr_eeprom_write(address, _eeprom.buffer, EEPROM_ALIAS_ROW_LENGTH))
+    if (!_eeprom_alias_reserve(_eeprom_alias_record_size_for(name_length)))
     {
         usb_talk_send_format("[\"$eeprom/alias/add/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
 
         return;
     }
 
-    if (i == _eeprom.alias_length)
+    eeprom_alias_record_t *record = &_eeprom.record;
+
+    memset(record, 0, sizeof(*record));
+
+    record->type = EEPROM_ALIAS_RECORD_SET;
+    record->length = name_length;
+    record->id = *id;
+
+    memcpy(record->name, name, name_length);
+
+    uint32_t address = _eeprom.end;
+
+    if (!_eeprom_alias_append(record))
     {
-        if (!_eeprom_alias_length_set(_eeprom.alias_length + 1))
-        {
-            usb_talk_send_format("[\"$eeprom/alias/add/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+        usb_talk_send_format("[\"$eeprom/alias/add/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
 
-            return;
-        }
+        return;
     }
 
+    _eeprom_alias_apply(address, record);
+
     usb_talk_send_format("[\"$eeprom/alias/add/ok\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
 }
 
 void eeprom_alias_remove(uint64_t *id)
 {
-    int i = _eeprom_alias_find_position_for_id(id);
+    if (!_eeprom_alias_remove(id))
+    {
+        usb_talk_send_format("[\"$eeprom/alias/remove/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
 
-    if (i != -1)
+        return;
+    }
+
+    usb_talk_send_format("[\"$eeprom/alias/remove/ok\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+}
+
+void eeprom_alias_list(int page)
+{
+    if ((page < 0) || (page >= EEPROM_ALIAS_PAGE_LENGTH))
     {
-        if ((i != _eeprom.alias_length) && (_eeprom.alias_length > 1))
-        {
-            // laste record
-            uint32_t address = EEPROM_ALIAS_ADDRESS_START + ((_eeprom.alias_length - 1) * EEPROM_ALIAS_ROW_LENGTH);
+        return;
+    }
+
+    _eeprom_alias_chunk_send("$eeprom/alias/list/%d", page);
+}
 
-            twr_eeprom_read(address, _eeprom.buffer, EEPROM_ALIAS_ROW_LENGTH);
+void eeprom_alias_dump(void)
+{
+    // A dump asked for again while running starts over
+    _eeprom.dump_chunk = 0;
 
-            address = EEPROM_ALIAS_ADDRESS_START + (i * EEPROM_ALIAS_ROW_LENGTH);
+    twr_scheduler_plan_now(_eeprom.dump_task_id);
+}
 
-            if (!twr_eeprom_write(address, _eeprom.buffer, EEPROM_ALIAS_ROW_LENGTH))
-            {
-                usb_talk_send_format("[\"$eeprom/alias/remove/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+bool eeprom_alias_resolve(const char *name, size_t length, uint64_t *id)
+{
+    if ((length == 0) || (length > EEPROM_ALIAS_NAME_LENGTH))
+    {
+        return false;
+    }
 
-                return;
-            }
-        }
+    uint16_t hash = _eeprom_alias_name_hash(name, length);
+
+    uint32_t slot = hash & (EEPROM_ALIAS_INDEX_LENGTH - 1);
+
+    int found = -1;
 
-        if (!_eeprom_alias_length_set(_eeprom.alias_length - 1))
+    // Only rows with the same hash and length are read back, normally exactly one
+    while (_eeprom.alias_name_index[slot] != 0)
+    {
+        int i = _eeprom.alias_name_index[slot] - 1;
+
+        if ((_eeprom.alias_name_hash[i] == hash) && (_eeprom.alias_name_length[i] == length) && _eeprom_alias_name_equal(i, name, length))
         {
-            usb_talk_send_format("[\"$eeprom/alias/remove/error\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+            if (found != -1)
+            {
+                // Name given to more than one node
+                return false;
+            }
 
-            return;
+            found = i;
         }
+
+        slot = (slot + 1) & (EEPROM_ALIAS_INDEX_LENGTH - 1);
     }
 
-    usb_talk_send_format("[\"$eeprom/alias/remove/ok\", \"" USB_TALK_DEVICE_ADDRESS "\"]\n", *id);
+    if (found == -1)
+    {
+        return false;
+    }
+
+    *id = _eeprom.alias_id[found];
+
+    return true;
 }
 
-void eeprom_alias_list(int page)
+bool eeprom_alias_begin(int count, size_t names_length)
 {
-    if (page >= EEPROM_ALIAS_PAGE_LENGTH)
+    if ((count <= 0) || _eeprom.transaction)
     {
-        return;
+        return false;
     }
 
-    int max_i = (page + 1) * EEPROM_ALIAS_ON_PAGE;
+    // Padding of each name is 3 bytes at most, the commit record has no name
+    size_t size = (count * (EEPROM_ALIAS_RECORD_HEAD_LENGTH + 3)) + names_length + EEPROM_ALIAS_RECORD_HEAD_LENGTH;
 
-    if (max_i >  _eeprom.alias_length)
+    // Room for the whole transaction up front, a compaction in the middle would drop it
+    if (!_eeprom_alias_reserve(size))
     {
-        max_i = _eeprom.alias_length;
+        return false;
     }
 
-    uint32_t address;
-    uint64_t *pid;
-    bool comma = false;
+    _eeprom.transaction = true;
+    _eeprom.transaction_start = _eeprom.end;
+    _eeprom.transaction_sequence = _eeprom.sequence;
+    _eeprom.transaction_left = count;
+    _eeprom.transaction_new = 0;
+    _eeprom.transaction_size = _eeprom.alias_size;
 
-    usb_talk_message_start("$eeprom/alias/list/%d", page);
-    usb_talk_message_append("{");
+    return true;
+}
 
-    for (int i = page * EEPROM_ALIAS_ON_PAGE; i < max_i; i++)
+bool eeprom_alias_stage(uint64_t *id, char *name)
+{
+    if (!_eeprom.transaction || (_eeprom.transaction_left == 0))
     {
-        address = EEPROM_ALIAS_ADDRESS_START + (i * EEPROM_ALIAS_ROW_LENGTH);
+        return false;
+    }
+
+    int i = _eeprom_alias_find_position_for_id(id);
 
-        twr_eeprom_read(address, _eeprom.buffer, EEPROM_ALIAS_ROW_LENGTH);
+    size_t name_length = strnlen(name, EEPROM_ALIAS_NAME_LENGTH);
+
+    _eeprom.transaction_left--;
+
+    // Provisioning the same set again writes nothing but the commit
+    if ((i != -1) && _eeprom_alias_name_equal(i, name, name_length))
+    {
+        return true;
+    }
 
-        if (comma)
+    if (i == -1)
+    {
+        // A new ID staged twice counts twice, the limits err on the safe side
+        if (_eeprom.alias_length + ++_eeprom.transaction_new > EEPROM_ALIAS_MAX)
         {
-            usb_talk_message_append(",");
+            return false;
         }
+    }
+
+    if (!_eeprom_alias_fits(i, name_length, &_eeprom.transaction_size))
+    {
+        return false;
+    }
 
-        pid = (uint64_t *)_eeprom.buffer;
+    // Names longer than announced to eeprom_alias_begin would run into the commit record
+    if (_eeprom.end + _eeprom_alias_record_size_for(name_length) + EEPROM_ALIAS_RECORD_HEAD_LENGTH > _eeprom_alias_half_end())
+    {
+        return false;
+    }
+
+    eeprom_alias_record_t *record = &_eeprom.record;
 
-        usb_talk_message_append("\"" USB_TALK_DEVICE_ADDRESS "\": \"%s\"", *pid, _eeprom.buffer + 8);
+    memset(record, 0, sizeof(*record));
+
+    record->type = EEPROM_ALIAS_RECORD_PENDING;
+    record->length = name_length;
+    record->id = *id;
+
+    memcpy(record->name, name, name_length);
+
+    return _eeprom_alias_append(record);
+}
 
-        comma = true;
+bool eeprom_alias_commit(void)
+{
+    if (!_eeprom.transaction)
+    {
+        return false;
     }
 
-    usb_talk_message_append("}");
+    eeprom_alias_record_t record;
 
-    usb_talk_message_send();
+    memset(&record, 0, sizeof(record));
+
+    record.type = EEPROM_ALIAS_RECORD_COMMIT;
+
+    uint32_t address = _eeprom.end;
+
+    if (!_eeprom_alias_append(&record))
+    {
+        eeprom_alias_abort();
+
+        return false;
+    }
+
+    _eeprom.transaction = false;
+
+    // Same path as the replay on boot
+    _eeprom_alias_apply_pending(_eeprom.transaction_start, address, &record);
+
+    return true;
+}
+
+void eeprom_alias_abort(void)
+{
+    if (!_eeprom.transaction)
+    {
+        return;
+    }
+
+    // Staged records are not followed by a commit, the next records overwrite them
+    _eeprom.end = _eeprom.transaction_start;
+    _eeprom.sequence = _eeprom.transaction_sequence;
+
+    _eeprom.transaction = false;
 }
 
 void eeprom_alias_purge(void)
 {
-    _eeprom_alias_length_set(0);
+    int length = _eeprom.alias_length;
+
+    // Empty log in the other half, the old aliases go away with one header write
+    _eeprom.alias_length = 0;
+
+    if (!_eeprom_alias_compact())
+    {
+        _eeprom.alias_length = length;
+
+        return;
+    }
+
+    _eeprom_alias_index_build();
 }
 
 static int _eeprom_alias_find_position_for_id(uint64_t *id)
 {
-    uint32_t address = EEPROM_ALIAS_ADDRESS_START;
-    uint64_t tmp_id;
+    uint32_t slot = _eeprom_alias_index_hash(id);
 
-    for (int i = 0; i < _eeprom.alias_length; i++)
+    // Never full, the table has twice as many slots as rows
+    while (_eeprom.alias_index[slot] != 0)
     {
-        twr_eeprom_read(address, &tmp_id, sizeof(tmp_id));
+        int i = _eeprom.alias_index[slot] - 1;
 
-        if (tmp_id == *id)
+        if (_eeprom.alias_id[i] == *id)
         {
             return i;
         }
 
-        address += EEPROM_ALIAS_ROW_LENGTH;
+        slot = (slot + 1) & (EEPROM_ALIAS_INDEX_LENGTH - 1);
     }
 
     return -1;
 }
 
-static bool _eeprom_alias_length_set(uint8_t length)
+static void _eeprom_alias_index_build(void)
+{
+    // Rows move on remove, rebuilding 64 entries is cheaper than tracking them
+    memset(_eeprom.alias_index, 0, sizeof(_eeprom.alias_index));
+    memset(_eeprom.alias_name_index, 0, sizeof(_eeprom.alias_name_index));
+
+    for (int i = 0; i < _eeprom.alias_length; i++)
+    {
+        uint32_t slot = _eeprom_alias_index_hash(&_eeprom.alias_id[i]);
+
+        while (_eeprom.alias_index[slot] != 0)
+        {
+            slot = (slot + 1) & (EEPROM_ALIAS_INDEX_LENGTH - 1);
+        }
+
+        _eeprom.alias_index[slot] = i + 1;
+
+        slot = _eeprom.alias_name_hash[i] & (EEPROM_ALIAS_INDEX_LENGTH - 1);
+
+        while (_eeprom.alias_name_index[slot] != 0)
+        {
+            slot = (slot + 1) & (EEPROM_ALIAS_INDEX_LENGTH - 1);
+        }
+
+        _eeprom.alias_name_index[slot] = i + 1;
+    }
+}
+
+static uint16_t _eeprom_alias_name_hash(const char *name, size_t length)
+{
+    // FNV-1a folded to 16 bits
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) name[i];
+
+        hash *= 16777619u;
+    }
+
+    return (uint16_t) (hash ^ (hash >> 16));
+}
+
+static uint32_t _eeprom_alias_index_hash(uint64_t *id)
+{
+    // Fibonacci hashing, the low bits of node IDs are not spread evenly
+    uint32_t hash = (uint32_t) (*id ^ (*id >> 32)) * 2654435769u;
+
+    return (hash >> 16) & (EEPROM_ALIAS_INDEX_LENGTH - 1);
+}
+
+static bool _eeprom_alias_load(void)
+{
+    uint32_t generation[2];
+
+    bool valid[2];
+
+    valid[0] = _eeprom_alias_header_read(0, &generation[0]);
+    valid[1] = _eeprom_alias_header_read(1, &generation[1]);
+
+    if (!valid[0] && !valid[1])
+    {
+        return false;
+    }
+
+    // After the first compaction both are, the older header stays until its half is reused
+    if (valid[0] && valid[1])
+    {
+        _eeprom.half = (int32_t) (generation[1] - generation[0]) > 0 ? 1 : 0;
+    }
+    else
+    {
+        _eeprom.half = valid[1] ? 1 : 0;
+    }
+
+    _eeprom.generation = generation[_eeprom.half];
+    _eeprom.alias_length = 0;
+    _eeprom.alias_size = 0;
+    _eeprom.sequence = 0;
+
+    uint32_t address = EEPROM_ALIAS_LOG_ADDRESS + (_eeprom.half * EEPROM_ALIAS_LOG_HALF_LENGTH) + sizeof(eeprom_alias_header_t);
+    uint32_t half_end = _eeprom_alias_half_end();
+
+    eeprom_alias_record_t record;
+
+    // First record of an open transaction, zero is never a record address
+    uint32_t pending = 0;
+    uint16_t pending_sequence = 0;
+
+    // Replay up to the first record that is torn, erased or out of sequence
+    while (address + EEPROM_ALIAS_RECORD_HEAD_LENGTH <= half_end)
+    {
+        if (!_eeprom_alias_record_read(address, &record))
+        {
+            break;
+        }
+
+        size_t size = _eeprom_alias_record_size(&record);
+
+        if ((address + size > half_end) || (record.sequence != _eeprom.sequence) || (record.crc != _eeprom_alias_record_crc(_eeprom.generation, &record)))
+        {
+            break;
+        }
+
+        if (record.type == EEPROM_ALIAS_RECORD_PENDING)
+        {
+            if (pending == 0)
+            {
+                pending = address;
+                pending_sequence = _eeprom.sequence;
+            }
+        }
+        else if (record.type == EEPROM_ALIAS_RECORD_COMMIT)
+        {
+            if (pending != 0)
+            {
+                _eeprom_alias_apply_pending(pending, address, &record);
+            }
+
+            pending = 0;
+        }
+        else
+        {
+            _eeprom_alias_apply(address, &record);
+        }
+
+        address += size;
+
+        _eeprom.sequence++;
+    }
+
+    // Transaction without a commit record is dropped, the next records go over it
+    if (pending != 0)
+    {
+        address = pending;
+
+        _eeprom.sequence = pending_sequence;
+    }
+
+    _eeprom.end = address;
+
+    return true;
+}
+
+static bool _eeprom_alias_legacy_load(void)
 {
     uint8_t buffer[2];
 
-    buffer[0] = length;
-    buffer[1] = ~length;
+    if (!twr_eeprom_read(EEPROM_ALIAS_ADDRESS_LENGTH, buffer, sizeof(buffer)))
+    {
+        return false;
+    }
+
+    uint8_t neg = ~buffer[1];
 
-    if (!twr_eeprom_write(EEPROM_ALIAS_ADDRESS_LENGTH, buffer, sizeof(buffer)))
+    if (buffer[0] != neg)
     {
         return false;
     }
 
-    _eeprom.alias_length = length;
+    // Rows past the last page were never listed, older firmware did not limit adding
+    int rows = buffer[0] > EEPROM_ALIAS_LEGACY_MAX ? EEPROM_ALIAS_LEGACY_MAX : buffer[0];
+
+    _eeprom.alias_length = 0;
+
+    for (int row = 0; row < rows; row++)
+    {
+        int i = _eeprom.alias_length;
+
+        _eeprom.alias_address[i] = EEPROM_ALIAS_ADDRESS_START + (row * EEPROM_ALIAS_ROW_LENGTH);
+        _eeprom.alias_name_length[i] = EEPROM_ALIAS_NAME_LENGTH;
+
+        if (!twr_eeprom_read(_eeprom.alias_address[i], &_eeprom.alias_id[i], sizeof(uint64_t)))
+        {
+            continue;
+        }
+
+        // A boot cleanup cut short by a failed write left a moved row in two places, both copies hold the same name
+        bool duplicate = false;
+
+        for (int j = 0; j < i; j++)
+        {
+            if (_eeprom.alias_id[j] == _eeprom.alias_id[i])
+            {
+                duplicate = true;
+
+                break;
+            }
+        }
+
+        if (!duplicate)
+        {
+            _eeprom.alias_length++;
+        }
+    }
+
+    _eeprom_alias_index_build();
+
+    _eeprom.legacy = true;
+
+    return true;
+}
+
+static bool _eeprom_alias_header_read(int half, uint32_t *generation)
+{
+    eeprom_alias_header_t header;
+
+    if (!twr_eeprom_read(EEPROM_ALIAS_LOG_ADDRESS + (half * EEPROM_ALIAS_LOG_HALF_LENGTH), &header, sizeof(header)))
+    {
+        return false;
+    }
+
+    if ((header.magic != EEPROM_ALIAS_LOG_MAGIC) || (header.crc != crc16(CRC16_INIT, &header, offsetof(eeprom_alias_header_t, crc))))
+    {
+        return false;
+    }
+
+    *generation = header.generation;
+
+    return true;
+}
+
+static bool _eeprom_alias_header_write(int half, uint32_t generation)
+{
+    eeprom_alias_header_t header;
+
+    memset(&header, 0, sizeof(header));
+
+    header.magic = EEPROM_ALIAS_LOG_MAGIC;
+    header.generation = generation;
+    header.crc = crc16(CRC16_INIT, &header, offsetof(eeprom_alias_header_t, crc));
+
+    return twr_eeprom_write(EEPROM_ALIAS_LOG_ADDRESS + (half * EEPROM_ALIAS_LOG_HALF_LENGTH), &header, sizeof(header));
+}
+
+static size_t _eeprom_alias_record_size(eeprom_alias_record_t *record)
+{
+    return _eeprom_alias_record_size_for(record->length);
+}
+
+static size_t _eeprom_alias_record_size_for(size_t name_length)
+{
+    return EEPROM_ALIAS_RECORD_HEAD_LENGTH + ((name_length + 3) & ~3);
+}
+
+static bool _eeprom_alias_name_equal(int i, const char *name, size_t name_length)
+{
+    // Legacy rows keep the name at another offset, they are only read to migrate them
+    if (_eeprom.legacy || (_eeprom.alias_name_length[i] != name_length))
+    {
+        return false;
+    }
+
+    uint32_t address = _eeprom.alias_address[i] + EEPROM_ALIAS_RECORD_HEAD_LENGTH;
+
+    char buffer[8];
+
+    for (size_t offset = 0; offset < name_length; offset += sizeof(buffer))
+    {
+        size_t length = name_length - offset < sizeof(buffer) ? name_length - offset : sizeof(buffer);
+
+        if (!twr_eeprom_read(address + offset, buffer, length) || (memcmp(buffer, name + offset, length) != 0))
+        {
+            return false;
+        }
+    }
 
     return true;
 }
+
+static bool _eeprom_alias_fits(int i, size_t name_length, size_t *size)
+{
+    // Live records must leave room in a half for one more record after a compaction
+    size_t new_size = *size + _eeprom_alias_record_size_for(name_length);
+
+    if (i != -1)
+    {
+        new_size -= _eeprom_alias_record_size_for(_eeprom.alias_name_length[i]);
+    }
+
+    if (new_size > EEPROM_ALIAS_LOG_HALF_LENGTH - sizeof(eeprom_alias_header_t) - (2 * sizeof(eeprom_alias_record_t)))
+    {
+        return false;
+    }
+
+    *size = new_size;
+
+    return true;
+}
+
+static bool _eeprom_alias_record_read(uint32_t address, eeprom_alias_record_t *record)
+{
+    if (_eeprom.legacy)
+    {
+        // Legacy row is the ID and name part of a record
+        record->type = EEPROM_ALIAS_RECORD_SET;
+        record->length = EEPROM_ALIAS_NAME_LENGTH;
+
+        return twr_eeprom_read(address, &record->id, EEPROM_ALIAS_ROW_LENGTH);
+    }
+
+    if (!twr_eeprom_read(address, record, EEPROM_ALIAS_RECORD_HEAD_LENGTH))
+    {
+        return false;
+    }
+
+    if ((record->type < EEPROM_ALIAS_RECORD_SET) || (record->type > EEPROM_ALIAS_RECORD_COMMIT))
+    {
+        return false;
+    }
+
+    if (record->length > EEPROM_ALIAS_NAME_LENGTH)
+    {
+        return false;
+    }
+
+    size_t size = _eeprom_alias_record_size(record);
+
+    return twr_eeprom_read(address + EEPROM_ALIAS_RECORD_HEAD_LENGTH, record->name, size - EEPROM_ALIAS_RECORD_HEAD_LENGTH);
+}
+
+static uint16_t _eeprom_alias_record_crc(uint32_t generation, eeprom_alias_record_t *record)
+{
+    uint16_t crc = crc16(CRC16_INIT, &generation, sizeof(generation));
+
+    return crc16(crc, &record->sequence, _eeprom_alias_record_size(record) - sizeof(record->crc));
+}
+
+static uint32_t _eeprom_alias_half_end(void)
+{
+    return EEPROM_ALIAS_LOG_ADDRESS + ((_eeprom.half + 1) * EEPROM_ALIAS_LOG_HALF_LENGTH);
+}
+
+static bool _eeprom_alias_reserve(size_t size)
+{
+    if (_eeprom.end + size <= _eeprom_alias_half_end())
+    {
+        return true;
+    }
+
+    // Half is full, live records move to the other one
+    if (!_eeprom_alias_compact())
+    {
+        return false;
+    }
+
+    return _eeprom.end + size <= _eeprom_alias_half_end();
+}
+
+static bool _eeprom_alias_append(eeprom_alias_record_t *record)
+{
+    record->sequence = _eeprom.sequence;
+    record->crc = _eeprom_alias_record_crc(_eeprom.generation, record);
+
+    size_t size = _eeprom_alias_record_size(record);
+
+    if (!twr_eeprom_write(_eeprom.end, record, size))
+    {
+        // The torn record ends the log on the next boot, write the next one over it
+        return false;
+    }
+
+    _eeprom.end += size;
+
+    _eeprom.sequence++;
+
+    return true;
+}
+
+static bool _eeprom_alias_compact(void)
+{
+    eeprom_alias_record_t *record = &_eeprom.record;
+
+    int half = _eeprom.half == 0 ? 1 : 0;
+
+    uint32_t generation = _eeprom.generation + 1;
+
+    uint32_t address = EEPROM_ALIAS_LOG_ADDRESS + (half * EEPROM_ALIAS_LOG_HALF_LENGTH) + sizeof(eeprom_alias_header_t);
+
+    uint16_t sequence = 0;
+
+    size_t alias_size = 0;
+
+    bool ok = true;
+
+    // Header goes last, until then a power cut leaves the current half in use
+    for (int i = 0; ok && (i < _eeprom.alias_length); i++)
+    {
+        if (!_eeprom_alias_record_read(_eeprom.alias_address[i], record))
+        {
+            ok = false;
+
+            break;
+        }
+
+        // Committed bulk records are plain ones from now on, zero padded names lose the padding
+        record->type = EEPROM_ALIAS_RECORD_SET;
+        record->length = strnlen(record->name, record->length);
+        record->sequence = sequence++;
+        record->crc = _eeprom_alias_record_crc(generation, record);
+
+        size_t size = _eeprom_alias_record_size(record);
+
+        ok = twr_eeprom_write(address, record, size);
+
+        _eeprom.alias_address[i] = address;
+        _eeprom.alias_name_length[i] = record->length;
+        _eeprom.alias_name_hash[i] = _eeprom_alias_name_hash(record->name, record->length);
+
+        alias_size += size;
+
+        address += size;
+    }
+
+    if (!ok || !_eeprom_alias_header_write(half, generation))
+    {
+        // Addresses were changed on the way, read them again, the next write retries
+        if (_eeprom.legacy)
+        {
+            _eeprom_alias_legacy_load();
+        }
+        else
+        {
+            _eeprom_alias_load();
+        }
+
+        return false;
+    }
+
+    _eeprom.legacy = false;
+    _eeprom.half = half;
+    _eeprom.generation = generation;
+    _eeprom.end = address;
+    _eeprom.sequence = sequence;
+    _eeprom.alias_size = alias_size;
+
+    // Name hashes and lengths changed above, legacy rows had none at all
+    _eeprom_alias_index_build();
+
+    return true;
+}
+
+static bool _eeprom_alias_remove(uint64_t *id)
+{
+    int i = _eeprom_alias_find_position_for_id(id);
+
+    if (i == -1)
+    {
+        return true;
+    }
+
+    eeprom_alias_record_t record;
+
+    memset(&record, 0, sizeof(record));
+
+    record.type = EEPROM_ALIAS_RECORD_REMOVE;
+    record.id = *id;
+
+    if (!_eeprom_alias_reserve(_eeprom_alias_record_size(&record)))
+    {
+        return false;
+    }
+
+    if (!_eeprom_alias_append(&record))
+    {
+        return false;
+    }
+
+    _eeprom_alias_forget(i);
+
+    return true;
+}
+
+static void _eeprom_alias_forget(int i)
+{
+    _eeprom.alias_size -= _eeprom_alias_record_size_for(_eeprom.alias_name_length[i]);
+
+    _eeprom.alias_length--;
+
+    _eeprom.alias_id[i] = _eeprom.alias_id[_eeprom.alias_length];
+    _eeprom.alias_address[i] = _eeprom.alias_address[_eeprom.alias_length];
+    _eeprom.alias_name_length[i] = _eeprom.alias_name_length[_eeprom.alias_length];
+    _eeprom.alias_name_hash[i] = _eeprom.alias_name_hash[_eeprom.alias_length];
+
+    _eeprom_alias_index_build();
+}
+
+static void _eeprom_alias_apply(uint32_t address, eeprom_alias_record_t *record)
+{
+    int i = _eeprom_alias_find_position_for_id(&record->id);
+
+    if (record->type == EEPROM_ALIAS_RECORD_REMOVE)
+    {
+        if (i != -1)
+        {
+            _eeprom_alias_forget(i);
+        }
+
+        return;
+    }
+
+    if ((i == -1) && (_eeprom.alias_length < EEPROM_ALIAS_MAX))
+    {
+        i = _eeprom.alias_length++;
+
+        _eeprom.alias_id[i] = record->id;
+        _eeprom.alias_name_length[i] = 0;
+
+        _eeprom.alias_size += _eeprom_alias_record_size_for(0);
+    }
+
+    if (i == -1)
+    {
+        return;
+    }
+
+    // Zero padded names of older firmware count as the short form they get on compaction
+    size_t name_length = strnlen(record->name, record->length);
+
+    _eeprom.alias_size += _eeprom_alias_record_size_for(name_length) - _eeprom_alias_record_size_for(_eeprom.alias_name_length[i]);
+
+    _eeprom.alias_address[i] = address;
+    _eeprom.alias_name_length[i] = name_length;
+    _eeprom.alias_name_hash[i] = _eeprom_alias_name_hash(record->name, name_length);
+
+    _eeprom_alias_index_build();
+}
+
+static void _eeprom_alias_apply_pending(uint32_t address, uint32_t end, eeprom_alias_record_t *record)
+{
+    // Records were checked when written or replayed, only the placement is needed again
+    while ((address < end) && _eeprom_alias_record_read(address, record))
+    {
+        _eeprom_alias_apply(address, record);
+
+        address += _eeprom_alias_record_size(record);
+    }
+}
+
+static void _eeprom_alias_dump_task(void *param)
+{
+    (void) param;
+
+    if (_eeprom.dump_chunk * EEPROM_ALIAS_ON_PAGE >= _eeprom.alias_length)
+    {
+        usb_talk_send_format("[\"$eeprom/alias/dump\", %d]\n", _eeprom.alias_length);
+
+        return;
+    }
+
+    // One chunk per pass and only once the host drained enough of the previous ones
+    if (!usb_talk_is_tx_ready())
+    {
+        twr_scheduler_plan_current_relative(EEPROM_ALIAS_DUMP_RETRY);
+
+        return;
+    }
+
+    _eeprom_alias_chunk_send("$eeprom/alias/dump/%d", _eeprom.dump_chunk);
+
+    _eeprom.dump_chunk++;
+
+    twr_scheduler_plan_current_now();
+}
+
+static void _eeprom_alias_chunk_send(const char *topic, int chunk)
+{
+    int max_i = (chunk + 1) * EEPROM_ALIAS_ON_PAGE;
+
+    if (max_i > _eeprom.alias_length)
+    {
+        max_i = _eeprom.alias_length;
+    }
+
+    usb_talk_message_start(topic, chunk);
+
+    usb_talk_message_object_begin();
+
+    for (int i = chunk * EEPROM_ALIAS_ON_PAGE; i < max_i; i++)
+    {
+        if (!_eeprom_alias_record_read(_eeprom.alias_address[i], &_eeprom.record))
+        {
+            continue;
+        }
+
+        memcpy(_eeprom.name, _eeprom.record.name, _eeprom.record.length);
+
+        _eeprom.name[_eeprom.record.length] = 0;
+
+        usb_talk_message_key_node_id(&_eeprom.alias_id[i]);
+
+        usb_talk_message_string(_eeprom.name);
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
@@ -3,13 +3,67 @@
 
 #include <twr_eeprom.h>
 
+// Legacy flat table, read once to migrate into the log
 #define EEPROM_ALIAS_ADDRESS_LENGTH    0x00
 #define EEPROM_ALIAS_ADDRESS_START     0x04
+// Rows older firmware listed on its four pages, rows from 60 on would lie in the second log half
+#define EEPROM_ALIAS_LEGACY_MAX        32
+// Longest name, the log stores names with their length, legacy rows padded with zeros
 #define EEPROM_ALIAS_NAME_LENGTH       32
 #define EEPROM_ALIAS_ROW_LENGTH        (8 + EEPROM_ALIAS_NAME_LENGTH)
 #define EEPROM_ALIAS_ON_PAGE           8
-#define EEPROM_ALIAS_PAGE_LENGTH       4
+#define EEPROM_ALIAS_PAGE_LENGTH       8
+#define EEPROM_ALIAS_MAX               (EEPROM_ALIAS_ON_PAGE * EEPROM_ALIAS_PAGE_LENGTH)
+// Open addressing slots of the RAM index, power of two, twice the rows keeps probes short
+#define EEPROM_ALIAS_INDEX_LENGTH      (2 * EEPROM_ALIAS_MAX)
+// Dump waits this long for the host to drain a chunk, at 115200 baud a full one takes about 45 ms
+#define EEPROM_ALIAS_DUMP_RETRY        20
 
+// The SDK radio keeps its peer table of 32 devices, 24 bytes each, below the last 8 bytes of the 6 KB EEPROM
+#define EEPROM_RADIO_ADDRESS           (0x1800 - 8 - (32 * 24))
+
+// Alias log, two halves used in turn, the first one overlaps the legacy table
+#define EEPROM_ALIAS_LOG_ADDRESS       0x0000
+#define EEPROM_ALIAS_LOG_HALF_LENGTH   0x0980
+#define EEPROM_ALIAS_LOG_MAGIC         0x474f4c41
+
+// Configuration right after the log up to the radio, one fixed 8 byte slot per key
+#define EEPROM_CONFIG_ADDRESS          (EEPROM_ALIAS_LOG_ADDRESS + (2 * EEPROM_ALIAS_LOG_HALF_LENGTH))
+#define EEPROM_CONFIG_LENGTH           (EEPROM_RADIO_ADDRESS - EEPROM_CONFIG_ADDRESS)
+
+#define EEPROM_ALIAS_RECORD_SET        0x01
+#define EEPROM_ALIAS_RECORD_REMOVE     0x02
+// Bulk set, pending records count only once the commit record follows
+#define EEPROM_ALIAS_RECORD_PENDING    0x03
+#define EEPROM_ALIAS_RECORD_COMMIT     0x04
+
+typedef struct
+{
+    uint32_t magic;
+    // Higher one is the current half
+    uint32_t generation;
+    uint16_t crc;
+    uint16_t reserved;
+
+} eeprom_alias_header_t;
+
+typedef struct
+{
+    // Seeded with the generation, so records left over from an older use of the half do not pass
+    uint16_t crc;
+    // Counts from zero in each half, a gap ends the log
+    uint16_t sequence;
+    uint8_t type;
+    // Name bytes stored without terminating zero, the record is padded to a multiple of 4
+    uint8_t length;
+    uint16_t reserved;
+    // ID and name in the same order as a legacy row
+    uint64_t id;
+    char name[EEPROM_ALIAS_NAME_LENGTH];
+
+} eeprom_alias_record_t;
+
+#define EEPROM_ALIAS_RECORD_HEAD_LENGTH offsetof(eeprom_alias_record_t, name)
 
 void eeprom_init(void);
 
@@ -21,5 +75,17 @@ void eeprom_alias_list(int page);
 
 void eeprom_alias_purge(void);
 
+void eeprom_alias_dump(void);
+
+bool eeprom_alias_resolve(const char *name, size_t length, uint64_t *id);
+
+bool eeprom_alias_begin(int count, size_t names_length);
+
+bool eeprom_alias_stage(uint64_t *id, char *name);
+
+bool eeprom_alias_commit(void);
+
+void eeprom_alias_abort(void);
+
 
 #endif // APP_EEPROM_H
@@ -0,0 +1,250 @@
+#include <filter.h>
+#include <usb_talk.h>
+
+#define FILTER_FLAG_EXCLUDE   0x01
+#define FILTER_FLAG_ANY_ID    0x02
+#define FILTER_FLAG_ANY_TOPIC 0x04
+
+// Pattern "<id>/<topic>", id is 12 hex digits or "+", topic is the first topic level or "+" or "#"
+// e.g. "+/thermometer", "836d19821bb4/#", "836d19821bb4"
+typedef struct
+{
+    uint64_t id;
+    // Quick reject, the topic itself confirms a match
+    uint32_t topic_hash;
+    uint8_t topic_length;
+    char topic[FILTER_TOPIC_LENGTH];
+    uint8_t flags;
+
+} filter_rule_t;
+
+static struct
+{
+    filter_rule_t rule[FILTER_RULE_MAX];
+    uint8_t length;
+    uint8_t include_length;
+
+} _filter;
+
+static uint32_t _filter_hash(const char *topic, size_t length);
+static bool _filter_rule_match(filter_rule_t *rule, uint64_t *id, const char *topic, size_t topic_length, uint32_t topic_hash);
+static void _filter_list_rules(int start, int end);
+
+void filter_clear(void)
+{
+    memset(&_filter, 0, sizeof(_filter));
+}
+
+bool filter_add(bool include, const char *pattern, size_t length)
+{
+    if (_filter.length >= FILTER_RULE_MAX)
+    {
+        return false;
+    }
+
+    filter_rule_t rule = { .flags = include ? 0 : FILTER_FLAG_EXCLUDE };
+
+    const char *topic = memchr(pattern, '/', length);
+
+    size_t id_length = topic != NULL ? (size_t) (topic - pattern) : length;
+
+    if ((id_length == 1) && (pattern[0] == '+'))
+    {
+        rule.flags |= FILTER_FLAG_ANY_ID;
+    }
+    else if (id_length == 12)
+    {
+        char str[13];
+
+        memcpy(str, pattern, 12);
+
+        str[12] = 0;
+
+        char *end;
+
+        rule.id = strtoull(str, &end, 16);
+
+        if (*end != '\0')
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (topic == NULL)
+    {
+        rule.flags |= FILTER_FLAG_ANY_TOPIC;
+    }
+    else
+    {
+        topic++;
+
+        size_t topic_length = length - (topic - pattern);
+
+        if ((topic_length == 1) && ((topic[0] == '#') || (topic[0] == '+')))
+        {
+            rule.flags |= FILTER_FLAG_ANY_TOPIC;
+        }
+        else if ((topic_length == 0) || (topic_length > FILTER_TOPIC_LENGTH) || (memchr(topic, '/', topic_length) != NULL))
+        {
+            return false;
+        }
+        else
+        {
+            rule.topic_hash = _filter_hash(topic, topic_length);
+
+            rule.topic_length = topic_length;
+
+            memcpy(rule.topic, topic, topic_length);
+        }
+    }
+
+    // Include rules first, so that the check can stop at the first match
+    if (include)
+    {
+        memmove(&_filter.rule[_filter.include_length + 1], &_filter.rule[_filter.include_length], (_filter.length - _filter.include_length) * sizeof(filter_rule_t));
+
+        _filter.rule[_filter.include_length++] = rule;
+    }
+    else
+    {
+        _filter.rule[_filter.length] = rule;
+    }
+
+    _filter.length++;
+
+    return true;
+}
+
+bool filter_pass(uint64_t *id, const char *topic)
+{
+    if (_filter.length == 0)
+    {
+        return true;
+    }
+
+    const char *end = strchr(topic, '/');
+
+    size_t topic_length = end != NULL ? (size_t) (end - topic) : strlen(topic);
+
+    uint32_t topic_hash = _filter_hash(topic, topic_length);
+
+    int i = 0;
+
+    if (_filter.include_length != 0)
+    {
+        for (; i < _filter.include_length; i++)
+        {
+            if (_filter_rule_match(&_filter.rule[i], id, topic, topic_length, topic_hash))
+            {
+                break;
+            }
+        }
+
+        if (i == _filter.include_length)
+        {
+            return false;
+        }
+
+        i = _filter.include_length;
+    }
+
+    for (; i < _filter.length; i++)
+    {
+        if (_filter_rule_match(&_filter.rule[i], id, topic, topic_length, topic_hash))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void filter_list(void)
+{
+    usb_talk_message_start("/filter");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("include");
+
+    _filter_list_rules(0, _filter.include_length);
+
+    usb_talk_message_key("exclude");
+
+    _filter_list_rules(_filter.include_length, _filter.length);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+static uint32_t _filter_hash(const char *topic, size_t length)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t) topic[i];
+
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool _filter_rule_match(filter_rule_t *rule, uint64_t *id, const char *topic, size_t topic_length, uint32_t topic_hash)
+{
+    if (!(rule->flags & FILTER_FLAG_ANY_ID) && (rule->id != *id))
+    {
+        return false;
+    }
+
+    if (rule->flags & FILTER_FLAG_ANY_TOPIC)
+    {
+        return true;
+    }
+
+    return (rule->topic_hash == topic_hash) && (rule->topic_length == topic_length) && (memcmp(rule->topic, topic, topic_length) == 0);
+}
+
+static void _filter_list_rules(int start, int end)
+{
+    // Patterns as given to filter_add, any topic is listed as "#"
+    char pattern[12 + 1 + FILTER_TOPIC_LENGTH + 1];
+
+    usb_talk_message_array_begin();
+
+    for (int i = start; i < end; i++)
+    {
+        filter_rule_t *rule = &_filter.rule[i];
+
+        int length;
+
+        if (rule->flags & FILTER_FLAG_ANY_ID)
+        {
+            length = snprintf(pattern, sizeof(pattern), "+/");
+        }
+        else
+        {
+            length = snprintf(pattern, sizeof(pattern), USB_TALK_DEVICE_ADDRESS "/", rule->id);
+        }
+
+        if (rule->flags & FILTER_FLAG_ANY_TOPIC)
+        {
+            snprintf(pattern + length, sizeof(pattern) - length, "#");
+        }
+        else
+        {
+            snprintf(pattern + length, sizeof(pattern) - length, "%.*s", rule->topic_length, rule->topic);
+        }
+
+        usb_talk_message_string(pattern);
+    }
+
+    usb_talk_message_array_end();
+}
@@ -0,0 +1,23 @@
+#ifndef _FILTER_H
+#define _FILTER_H
+
+#include <twr_common.h>
+
+#ifndef FILTER_RULE_MAX
+#define FILTER_RULE_MAX 16
+#endif
+
+// Longest first topic level a rule can name
+#ifndef FILTER_TOPIC_LENGTH
+#define FILTER_TOPIC_LENGTH 24
+#endif
+
+void filter_clear(void);
+
+bool filter_add(bool include, const char *pattern, size_t length);
+
+bool filter_pass(uint64_t *id, const char *topic);
+
+void filter_list(void);
+
+#endif // _FILTER_H
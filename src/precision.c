@@ -0,0 +1,161 @@
+#include <precision.h>
+#include <usb_talk.h>
+
+static const char *_precision_class_name[PRECISION_CLASS_COUNT] = {
+    [PRECISION_CLASS_TEMPERATURE] = "temperature",
+    [PRECISION_CLASS_HUMIDITY] = "relative-humidity",
+    [PRECISION_CLASS_ILLUMINANCE] = "illuminance",
+    [PRECISION_CLASS_PRESSURE] = "pressure",
+    [PRECISION_CLASS_ALTITUDE] = "altitude",
+    [PRECISION_CLASS_CONCENTRATION] = "concentration",
+    [PRECISION_CLASS_VOLTAGE] = "voltage",
+    [PRECISION_CLASS_ACCELERATION] = "acceleration",
+    [PRECISION_CLASS_FLOAT] = "float"
+};
+
+static struct
+{
+    uint8_t mode;
+    uint8_t digits;
+
+} _precision[PRECISION_CLASS_COUNT] = {
+    [PRECISION_CLASS_TEMPERATURE] = { PRECISION_MODE_DECIMALS, 2 },
+    [PRECISION_CLASS_HUMIDITY] = { PRECISION_MODE_DECIMALS, 1 },
+    [PRECISION_CLASS_ILLUMINANCE] = { PRECISION_MODE_DECIMALS, 1 },
+    [PRECISION_CLASS_PRESSURE] = { PRECISION_MODE_DECIMALS, 0 },
+    [PRECISION_CLASS_ALTITUDE] = { PRECISION_MODE_DECIMALS, 1 },
+    [PRECISION_CLASS_CONCENTRATION] = { PRECISION_MODE_DECIMALS, 0 },
+    [PRECISION_CLASS_VOLTAGE] = { PRECISION_MODE_DECIMALS, 2 },
+    [PRECISION_CLASS_ACCELERATION] = { PRECISION_MODE_DECIMALS, 3 },
+    [PRECISION_CLASS_FLOAT] = { PRECISION_MODE_DECIMALS, 2 }
+};
+
+precision_class_t precision_class_find(const char *subtopic)
+{
+    // The class is given by the last level of the topic, e.g. "thermometer/0:1/temperature"
+    const char *name = strrchr(subtopic, '/');
+
+    name = name != NULL ? name + 1 : subtopic;
+
+    precision_class_t precision_class;
+
+    if (precision_class_find_name(name, &precision_class))
+    {
+        return precision_class;
+    }
+
+    return PRECISION_CLASS_FLOAT;
+}
+
+bool precision_class_find_name(const char *name, precision_class_t *precision_class)
+{
+    for (int i = 0; i < PRECISION_CLASS_COUNT; i++)
+    {
+        if (strcmp(_precision_class_name[i], name) == 0)
+        {
+            *precision_class = (precision_class_t) i;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char *precision_class_get_name(precision_class_t precision_class)
+{
+    return _precision_class_name[precision_class];
+}
+
+void precision_set(precision_class_t precision_class, precision_mode_t mode, int digits)
+{
+    // Clamped before it is stored narrow, 256 must not wrap to 0
+    if (mode == PRECISION_MODE_DIGITS)
+    {
+        if (digits < 1)
+        {
+            digits = 1;
+        }
+        else if (digits > PRECISION_MAX_DECIMALS + 1)
+        {
+            digits = PRECISION_MAX_DECIMALS + 1;
+        }
+    }
+    else if (digits < 0)
+    {
+        digits = 0;
+    }
+    else if (digits > PRECISION_MAX_DECIMALS)
+    {
+        digits = PRECISION_MAX_DECIMALS;
+    }
+
+    _precision[precision_class].mode = mode;
+    _precision[precision_class].digits = (uint8_t) digits;
+}
+
+void precision_get(precision_class_t precision_class, precision_mode_t *mode, uint8_t *digits)
+{
+    *mode = (precision_mode_t) _precision[precision_class].mode;
+    *digits = _precision[precision_class].digits;
+}
+
+int precision_decimals(precision_class_t precision_class, const float *value)
+{
+    int decimals = _precision[precision_class].digits;
+
+    if (_precision[precision_class].mode == PRECISION_MODE_DECIMALS)
+    {
+        return decimals;
+    }
+
+    if ((value == NULL) || (*value == 0.f) || isnan(*value) || isinf(*value))
+    {
+        return 0;
+    }
+
+    float absolute = *value < 0 ? -*value : *value;
+
+    // One significant digit is taken by the units place
+    decimals--;
+
+    while ((absolute >= 10.f) && (decimals > 0))
+    {
+        absolute /= 10.f;
+
+        decimals--;
+    }
+
+    while ((absolute < 1.f) && (decimals < PRECISION_MAX_DECIMALS))
+    {
+        absolute *= 10.f;
+
+        decimals++;
+    }
+
+    return decimals;
+}
+
+void precision_list(void)
+{
+    usb_talk_message_start("/precision");
+
+    usb_talk_message_object_begin();
+
+    for (int i = 0; i < PRECISION_CLASS_COUNT; i++)
+    {
+        usb_talk_message_key(_precision_class_name[i]);
+
+        usb_talk_message_object_begin();
+
+        usb_talk_message_key(_precision[i].mode == PRECISION_MODE_DIGITS ? "digits" : "decimals");
+
+        usb_talk_message_uint(_precision[i].digits);
+
+        usb_talk_message_object_end();
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
@@ -0,0 +1,48 @@
+#ifndef _PRECISION_H
+#define _PRECISION_H
+
+#include <twr_common.h>
+
+#define PRECISION_MAX_DECIMALS 6
+
+typedef enum
+{
+    PRECISION_CLASS_TEMPERATURE = 0,
+    PRECISION_CLASS_HUMIDITY = 1,
+    PRECISION_CLASS_ILLUMINANCE = 2,
+    PRECISION_CLASS_PRESSURE = 3,
+    PRECISION_CLASS_ALTITUDE = 4,
+    PRECISION_CLASS_CONCENTRATION = 5,
+    PRECISION_CLASS_VOLTAGE = 6,
+    PRECISION_CLASS_ACCELERATION = 7,
+    // Any other float value
+    PRECISION_CLASS_FLOAT = 8,
+
+    PRECISION_CLASS_COUNT = 9
+
+} precision_class_t;
+
+typedef enum
+{
+    // Fixed number of digits after the decimal point
+    PRECISION_MODE_DECIMALS = 0,
+    // Number of significant digits, decimals follow the magnitude of the value
+    PRECISION_MODE_DIGITS = 1
+
+} precision_mode_t;
+
+precision_class_t precision_class_find(const char *subtopic);
+
+bool precision_class_find_name(const char *name, precision_class_t *precision_class);
+
+const char *precision_class_get_name(precision_class_t precision_class);
+
+void precision_set(precision_class_t precision_class, precision_mode_t mode, int digits);
+
+void precision_get(precision_class_t precision_class, precision_mode_t *mode, uint8_t *digits);
+
+int precision_decimals(precision_class_t precision_class, const float *value);
+
+void precision_list(void);
+
+#endif // _PRECISION_H
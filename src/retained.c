@@ -0,0 +1,239 @@
+#include <retained.h>
+#include <usb_talk.h>
+#include <precision.h>
+#include <math.h>
+
+typedef enum
+{
+    RETAINED_TYPE_NONE = 0,
+    RETAINED_TYPE_NULL = 1,
+    RETAINED_TYPE_BOOL = 2,
+    RETAINED_TYPE_INT = 3,
+    RETAINED_TYPE_UINT = 4,
+    RETAINED_TYPE_FLOAT = 5,
+    RETAINED_TYPE_VECTOR = 6
+
+} retained_type_t;
+
+typedef struct
+{
+    uint64_t id;
+    uint32_t stamp;
+
+    union
+    {
+        bool b;
+        int32_t i;
+        uint32_t u;
+        float f[3];
+
+    } value;
+
+    uint8_t type;
+    char topic[RETAINED_TOPIC_LENGTH];
+
+} retained_entry_t;
+
+static struct
+{
+    uint32_t stamp;
+
+    retained_entry_t entry[RETAINED_LENGTH];
+
+} _retained;
+
+static retained_entry_t *_retained_entry(uint64_t *id, const char *topic, retained_type_t type);
+
+void retained_null(uint64_t *id, const char *topic)
+{
+    _retained_entry(id, topic, RETAINED_TYPE_NULL);
+}
+
+void retained_bool(uint64_t *id, const char *topic, bool value)
+{
+    retained_entry_t *entry = _retained_entry(id, topic, RETAINED_TYPE_BOOL);
+
+    if (entry != NULL)
+    {
+        entry->value.b = value;
+    }
+}
+
+void retained_int(uint64_t *id, const char *topic, int32_t value)
+{
+    retained_entry_t *entry = _retained_entry(id, topic, RETAINED_TYPE_INT);
+
+    if (entry != NULL)
+    {
+        entry->value.i = value;
+    }
+}
+
+void retained_uint(uint64_t *id, const char *topic, uint32_t value)
+{
+    retained_entry_t *entry = _retained_entry(id, topic, RETAINED_TYPE_UINT);
+
+    if (entry != NULL)
+    {
+        entry->value.u = value;
+    }
+}
+
+void retained_float(uint64_t *id, const char *topic, float *value)
+{
+    if (value == NULL)
+    {
+        retained_null(id, topic);
+
+        return;
+    }
+
+    retained_entry_t *entry = _retained_entry(id, topic, RETAINED_TYPE_FLOAT);
+
+    if (entry != NULL)
+    {
+        entry->value.f[0] = *value;
+    }
+}
+
+void retained_vector(uint64_t *id, const char *topic, float *x_axis, float *y_axis, float *z_axis)
+{
+    retained_entry_t *entry = _retained_entry(id, topic, RETAINED_TYPE_VECTOR);
+
+    if (entry != NULL)
+    {
+        entry->value.f[0] = x_axis != NULL ? *x_axis : NAN;
+        entry->value.f[1] = y_axis != NULL ? *y_axis : NAN;
+        entry->value.f[2] = z_axis != NULL ? *z_axis : NAN;
+    }
+}
+
+void retained_clear(void)
+{
+    memset(&_retained, 0, sizeof(_retained));
+}
+
+void retained_replay(void)
+{
+    int count = 0;
+
+    for (int i = 0; i < RETAINED_LENGTH; i++)
+    {
+        retained_entry_t *entry = &_retained.entry[i];
+
+        if (entry->type == RETAINED_TYPE_NONE)
+        {
+            continue;
+        }
+
+        // Written directly, going through the publishers would refresh the stamps
+        usb_talk_message_start_id(&entry->id, "%s", entry->topic);
+
+        precision_class_t precision_class = precision_class_find(entry->topic);
+
+        switch (entry->type)
+        {
+            case RETAINED_TYPE_BOOL:
+            {
+                usb_talk_message_bool(entry->value.b);
+                break;
+            }
+            case RETAINED_TYPE_INT:
+            {
+                usb_talk_message_int(entry->value.i);
+                break;
+            }
+            case RETAINED_TYPE_UINT:
+            {
+                usb_talk_message_uint(entry->value.u);
+                break;
+            }
+            case RETAINED_TYPE_FLOAT:
+            {
+                usb_talk_message_float(&entry->value.f[0], precision_decimals(precision_class, &entry->value.f[0]));
+                break;
+            }
+            case RETAINED_TYPE_VECTOR:
+            {
+                usb_talk_message_array_begin();
+
+                for (int j = 0; j < 3; j++)
+                {
+                    usb_talk_message_float(&entry->value.f[j], precision_decimals(precision_class, &entry->value.f[j]));
+                }
+
+                usb_talk_message_array_end();
+                break;
+            }
+            case RETAINED_TYPE_NULL:
+            default:
+            {
+                usb_talk_message_null();
+                break;
+            }
+        }
+
+        usb_talk_message_send();
+
+        count++;
+    }
+
+    usb_talk_send_format("[\"/retained\", %d]\n", count);
+}
+
+static retained_entry_t *_retained_entry(uint64_t *id, const char *topic, retained_type_t type)
+{
+    size_t length = strlen(topic);
+
+    if (length >= RETAINED_TOPIC_LENGTH)
+    {
+        return NULL;
+    }
+
+    retained_entry_t *entry = NULL;
+    retained_entry_t *oldest = NULL;
+
+    for (int i = 0; i < RETAINED_LENGTH; i++)
+    {
+        retained_entry_t *item = &_retained.entry[i];
+
+        if (item->type == RETAINED_TYPE_NONE)
+        {
+            if ((oldest == NULL) || (oldest->type != RETAINED_TYPE_NONE))
+            {
+                oldest = item;
+            }
+
+            continue;
+        }
+
+        if ((item->id == *id) && (strcmp(item->topic, topic) == 0))
+        {
+            entry = item;
+
+            break;
+        }
+
+        // Unsigned difference keeps the order across stamp overflow
+        if ((oldest == NULL) || ((oldest->type != RETAINED_TYPE_NONE) && ((uint32_t) (_retained.stamp - item->stamp) > (uint32_t) (_retained.stamp - oldest->stamp))))
+        {
+            oldest = item;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        // Least recently updated entry is evicted when the cache is full
+        entry = oldest;
+
+        entry->id = *id;
+
+        memcpy(entry->topic, topic, length + 1);
+    }
+
+    entry->type = type;
+
+    entry->stamp = ++_retained.stamp;
+
+    return entry;
+}
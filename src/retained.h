@@ -0,0 +1,30 @@
+#ifndef _RETAINED_H
+#define _RETAINED_H
+
+#include <twr_common.h>
+
+#ifndef RETAINED_LENGTH
+#define RETAINED_LENGTH 32
+#endif
+// Including terminating zero, longer topics are not retained
+#ifndef RETAINED_TOPIC_LENGTH
+#define RETAINED_TOPIC_LENGTH 40
+#endif
+
+void retained_null(uint64_t *id, const char *topic);
+
+void retained_bool(uint64_t *id, const char *topic, bool value);
+
+void retained_int(uint64_t *id, const char *topic, int32_t value);
+
+void retained_uint(uint64_t *id, const char *topic, uint32_t value);
+
+void retained_float(uint64_t *id, const char *topic, float *value);
+
+void retained_vector(uint64_t *id, const char *topic, float *x_axis, float *y_axis, float *z_axis);
+
+void retained_clear(void);
+
+void retained_replay(void);
+
+#endif // _RETAINED_H
@@ -1,13 +1,84 @@
 #include <sensors.h>
 #include <usb_talk.h>
 #include <twr_radio_pub.h>
+#include <stats.h>
+#include <math.h>
+
+typedef struct
+{
+    const char *name;
+    twr_i2c_channel_t i2c_channel;
+    uint8_t i2c_address;
+    event_param_t *param;
+    config_key_t interval_key;
+
+    // NULL for modules running their own timer, tags are measured in the bus bursts
+    bool (*measure)(void *self);
+    void *self;
+    // Burst of the last measurement, zero before the first one
+    twr_tick_t measure_tick;
+
+} sensors_entry_t;
+
+typedef struct
+{
+    twr_i2c_channel_t i2c_channel;
+    twr_scheduler_task_id_t task_id;
+
+} sensors_bus_t;
+
+typedef struct
+{
+    config_key_t change;
+    config_key_t hysteresis;
+    config_key_t smoothing;
+    config_key_t rate;
+    config_key_t min_interval;
+    config_key_t no_change_interval;
+
+} sensors_filter_keys_t;
+
+static const sensors_filter_keys_t _sensors_filter_keys[SENSORS_CLASS_COUNT] = {
+    [SENSORS_CLASS_TEMPERATURE] = {CONFIG_KEY_TEMPERATURE_CHANGE, CONFIG_KEY_TEMPERATURE_HYSTERESIS, CONFIG_KEY_TEMPERATURE_SMOOTHING, CONFIG_KEY_TEMPERATURE_RATE, CONFIG_KEY_TEMPERATURE_MIN_INTERVAL, CONFIG_KEY_TEMPERATURE_NO_CHANGE_INTERVAL},
+    [SENSORS_CLASS_HUMIDITY] = {CONFIG_KEY_HUMIDITY_CHANGE, CONFIG_KEY_HUMIDITY_HYSTERESIS, CONFIG_KEY_HUMIDITY_SMOOTHING, CONFIG_KEY_HUMIDITY_RATE, CONFIG_KEY_HUMIDITY_MIN_INTERVAL, CONFIG_KEY_HUMIDITY_NO_CHANGE_INTERVAL},
+    [SENSORS_CLASS_LUX_METER] = {CONFIG_KEY_LUX_METER_CHANGE, CONFIG_KEY_LUX_METER_HYSTERESIS, CONFIG_KEY_LUX_METER_SMOOTHING, CONFIG_KEY_LUX_METER_RATE, CONFIG_KEY_LUX_METER_MIN_INTERVAL, CONFIG_KEY_LUX_METER_NO_CHANGE_INTERVAL},
+    [SENSORS_CLASS_BAROMETER] = {CONFIG_KEY_BAROMETER_CHANGE, CONFIG_KEY_BAROMETER_HYSTERESIS, CONFIG_KEY_BAROMETER_SMOOTHING, CONFIG_KEY_BAROMETER_RATE, CONFIG_KEY_BAROMETER_MIN_INTERVAL, CONFIG_KEY_BAROMETER_NO_CHANGE_INTERVAL},
+    [SENSORS_CLASS_CO2] = {CONFIG_KEY_CO2_CHANGE, CONFIG_KEY_CO2_HYSTERESIS, CONFIG_KEY_CO2_SMOOTHING, CONFIG_KEY_CO2_RATE, CONFIG_KEY_CO2_MIN_INTERVAL, CONFIG_KEY_CO2_NO_CHANGE_INTERVAL}
+};
 
 static uint64_t *_device_address;
 
+static struct
+{
+    sensors_entry_t entry[SENSORS_LENGTH];
+    int length;
+
+    sensors_bus_t bus[SENSORS_BUS_COUNT];
+
+} _sensors;
+
+static void _sensors_register(const char *name, twr_i2c_channel_t i2c_channel, uint8_t i2c_address, event_param_t *param, config_key_t interval_key, bool (*measure)(void *self), void *self);
+static bool _sensors_presence(event_param_t *param, bool present);
+static bool _sensors_filter(event_param_t *param, sensors_class_t sensors_class, float *value);
+static void _sensors_burst_task(void *param);
+static void _sensors_burst_plan(void);
+static twr_tick_t _sensors_burst_align(twr_tick_t tick);
+static bool _sensors_measure_temperature(void *self);
+static bool _sensors_measure_humidity(void *self);
+static bool _sensors_measure_lux_meter(void *self);
+static bool _sensors_measure_barometer(void *self);
+
 void sensors_init_all(uint64_t *my_device_address)
 {
 	_device_address = my_device_address;
 
+	// Both buses burst on the same boundaries, in between they stay idle
+	_sensors.bus[0].i2c_channel = TWR_I2C_I2C0;
+	_sensors.bus[0].task_id = twr_scheduler_register(_sensors_burst_task, &_sensors.bus[0], _sensors_burst_align(twr_tick_get()));
+
+	_sensors.bus[1].i2c_channel = TWR_I2C_I2C1;
+	_sensors.bus[1].task_id = twr_scheduler_register(_sensors_burst_task, &_sensors.bus[1], _sensors_burst_align(twr_tick_get()));
+
 	static temperature_tag_t temperature_tag_0_0;
 	temperature_tag_init(TWR_I2C_I2C0, TWR_TAG_TEMPERATURE_I2C_ADDRESS_DEFAULT, &temperature_tag_0_0);
 
@@ -74,21 +145,34 @@ static void temperature_tag_event_handler(twr_tag_temperature_t *self, twr_tag_t
     float value;
     event_param_t *param = (event_param_t *)event_param;
 
+    if (event == TWR_TAG_TEMPERATURE_EVENT_ERROR)
+    {
+        _sensors_presence(param, false);
+
+        return;
+    }
+
     if (event != TWR_TAG_TEMPERATURE_EVENT_UPDATE)
     {
         return;
     }
 
+    stats_mark_t start = stats_mark();
+
+    if (_sensors_presence(param, true))
+    {
+        _sensors_burst_plan();
+    }
+
     if (twr_tag_temperature_get_temperature_celsius(self, &value))
     {
-        if ((fabs(value - param->value) >= TEMPERATURE_TAG_PUB_VALUE_CHANGE) || (param->next_pub < twr_scheduler_get_spin_tick()))
+        if (_sensors_filter(param, SENSORS_CLASS_TEMPERATURE, &value))
         {
-        	usb_talk_publish_temperature(_device_address, param->channel, &value);
-
-            param->value = value;
-            param->next_pub = twr_scheduler_get_spin_tick() + TEMPERATURE_TAG_PUB_NO_CHANGE_INTEVAL;
+            usb_talk_publish_temperature(_device_address, param->channel, &value);
         }
     }
+
+    stats_task(STATS_TASK_TEMPERATURE_TAG, start);
 }
 
 void temperature_tag_init(twr_i2c_channel_t i2c_channel, twr_tag_temperature_i2c_address_t i2c_address, temperature_tag_t *tag)
@@ -97,9 +181,12 @@ void temperature_tag_init(twr_i2c_channel_t i2c_channel, twr_tag_temperature_i2c
 
     tag->param.channel = i2c_address == TWR_TAG_TEMPERATURE_I2C_ADDRESS_DEFAULT ? TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_DEFAULT: TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_ALTERNATE;
 
+    _sensors_register("temperature-tag", i2c_channel, i2c_address, &tag->param, CONFIG_KEY_TEMPERATURE_INTERVAL, _sensors_measure_temperature, &tag->self);
+
+    // The first burst is the probe, an absent tag backs off from its error
     twr_tag_temperature_init(&tag->self, i2c_channel, i2c_address);
 
-    twr_tag_temperature_set_update_interval(&tag->self, TEMPERATURE_TAG_UPDATE_INTERVAL);
+    twr_tag_temperature_set_update_interval(&tag->self, TWR_TICK_INFINITY);
 
     twr_tag_temperature_set_event_handler(&tag->self, temperature_tag_event_handler, &tag->param);
 }
@@ -109,38 +196,65 @@ static void humidity_tag_event_handler(twr_tag_humidity_t *self, twr_tag_humidit
     float value;
     event_param_t *param = (event_param_t *)event_param;
 
+    if (event == TWR_TAG_HUMIDITY_EVENT_ERROR)
+    {
+        _sensors_presence(param, false);
+
+        return;
+    }
+
     if (event != TWR_TAG_HUMIDITY_EVENT_UPDATE)
     {
         return;
     }
 
+    stats_mark_t start = stats_mark();
+
+    if (_sensors_presence(param, true))
+    {
+        _sensors_burst_plan();
+    }
+
     if (twr_tag_humidity_get_humidity_percentage(self, &value))
     {
-        if ((fabs(value - param->value) >= HUMIDITY_TAG_PUB_VALUE_CHANGE) || (param->next_pub < twr_scheduler_get_spin_tick()))
+        if (_sensors_filter(param, SENSORS_CLASS_HUMIDITY, &value))
         {
-        	 usb_talk_publish_humidity(_device_address, param->channel, &value);
-
-            param->value = value;
-            param->next_pub = twr_scheduler_get_spin_tick() + HUMIDITY_TAG_PUB_NO_CHANGE_INTEVAL;
+            usb_talk_publish_humidity(_device_address, param->channel, &value);
         }
     }
+
+    stats_task(STATS_TASK_HUMIDITY_TAG, start);
 }
 
 void humidity_tag_init(twr_tag_humidity_revision_t revision, twr_i2c_channel_t i2c_channel, humidity_tag_t *tag)
 {
     memset(tag, 0, sizeof(*tag));
 
+    const char *name;
+
+    // The SDK picks the sensor address by revision, the registry reports the one on the bus
+    uint8_t i2c_address;
+
     if (revision == TWR_TAG_HUMIDITY_REVISION_R1)
     {
         tag->param.channel = TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_DEFAULT;
+        name = "humidity-tag-r1";
+        // HTS221
+        i2c_address = 0x5f;
     }
     else if (revision == TWR_TAG_HUMIDITY_REVISION_R2)
     {
         tag->param.channel = TWR_RADIO_PUB_CHANNEL_R2_I2C0_ADDRESS_DEFAULT;
+        name = "humidity-tag-r2";
+        // HDC2080
+        i2c_address = 0x40;
     }
     else if (revision == TWR_TAG_HUMIDITY_REVISION_R3)
     {
         tag->param.channel = TWR_RADIO_PUB_CHANNEL_R3_I2C0_ADDRESS_DEFAULT;
+        name = "humidity-tag-r3";
+        // SHT20
+        i2c_address = 0x40;
     }
     else
     {
@@ -152,9 +266,11 @@ void humidity_tag_init(twr_tag_humidity_revision_t revision, twr_i2c_channel_t i
         tag->param.channel |= 0x80;
     }
 
+    _sensors_register(name, i2c_channel, i2c_address, &tag->param, CONFIG_KEY_HUMIDITY_INTERVAL, _sensors_measure_humidity, &tag->self);
+
     twr_tag_humidity_init(&tag->self, revision, i2c_channel, TWR_TAG_HUMIDITY_I2C_ADDRESS_DEFAULT);
 
-    twr_tag_humidity_set_update_interval(&tag->self, HUMIDITY_TAG_UPDATE_INTERVAL);
+    twr_tag_humidity_set_update_interval(&tag->self, TWR_TICK_INFINITY);
 
     twr_tag_humidity_set_event_handler(&tag->self, humidity_tag_event_handler, &tag->param);
 }
@@ -164,21 +280,34 @@ static void lux_meter_event_handler(twr_tag_lux_meter_t *self, twr_tag_lux_meter
     float value;
     event_param_t *param = (event_param_t *)event_param;
 
+    if (event == TWR_TAG_LUX_METER_EVENT_ERROR)
+    {
+        _sensors_presence(param, false);
+
+        return;
+    }
+
     if (event != TWR_TAG_LUX_METER_EVENT_UPDATE)
     {
         return;
     }
 
+    stats_mark_t start = stats_mark();
+
+    if (_sensors_presence(param, true))
+    {
+        _sensors_burst_plan();
+    }
+
     if (twr_tag_lux_meter_get_illuminance_lux(self, &value))
     {
-        if ((fabs(value - param->value) >= LUX_METER_TAG_PUB_VALUE_CHANGE) || (param->next_pub < twr_scheduler_get_spin_tick()))
+        if (_sensors_filter(param, SENSORS_CLASS_LUX_METER, &value))
         {
-        	 usb_talk_publish_lux_meter(_device_address, param->channel, &value);
-
-            param->value = value;
-            param->next_pub = twr_scheduler_get_spin_tick() + LUX_METER_TAG_PUB_NO_CHANGE_INTEVAL;
+            usb_talk_publish_lux_meter(_device_address, param->channel, &value);
         }
     }
+
+    stats_task(STATS_TASK_LUX_METER_TAG, start);
 }
 
 void lux_meter_tag_init(twr_i2c_channel_t i2c_channel, twr_tag_lux_meter_i2c_address_t i2c_address, lux_meter_tag_t *tag)
@@ -187,9 +316,11 @@ void lux_meter_tag_init(twr_i2c_channel_t i2c_channel, twr_tag_lux_meter_i2c_add
 
     tag->param.channel = i2c_address == TWR_TAG_LUX_METER_I2C_ADDRESS_DEFAULT ? TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_DEFAULT: TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_ALTERNATE;
 
+    _sensors_register("lux-meter-tag", i2c_channel, i2c_address, &tag->param, CONFIG_KEY_LUX_METER_INTERVAL, _sensors_measure_lux_meter, &tag->self);
+
     twr_tag_lux_meter_init(&tag->self, i2c_channel, i2c_address);
 
-    twr_tag_lux_meter_set_update_interval(&tag->self, LUX_METER_TAG_UPDATE_INTERVAL);
+    twr_tag_lux_meter_set_update_interval(&tag->self, TWR_TICK_INFINITY);
 
     twr_tag_lux_meter_set_event_handler(&tag->self, lux_meter_event_handler, &tag->param);
 }
@@ -200,28 +331,39 @@ static void barometer_tag_event_handler(twr_tag_barometer_t *self, twr_tag_barom
     float meter;
     event_param_t *param = (event_param_t *)event_param;
 
+    if (event == TWR_TAG_BAROMETER_EVENT_ERROR)
+    {
+        _sensors_presence(param, false);
+
+        return;
+    }
+
     if (event != TWR_TAG_BAROMETER_EVENT_UPDATE)
     {
         return;
     }
 
+    stats_mark_t start = stats_mark();
+
+    if (_sensors_presence(param, true))
+    {
+        _sensors_burst_plan();
+    }
+
     if (!twr_tag_barometer_get_pressure_pascal(self, &pascal))
     {
         return;
     }
 
-    if ((fabs(pascal - param->value) >= BAROMETER_TAG_PUB_VALUE_CHANGE) || (param->next_pub < twr_scheduler_get_spin_tick()))
+    if (_sensors_filter(param, SENSORS_CLASS_BAROMETER, &pascal))
     {
-        if (!twr_tag_barometer_get_altitude_meter(self, &meter))
-        {
-            return;
-        }
+        // Standard atmosphere altitude of the pressure sent, the sensor one belongs to the raw sample
+        meter = 44330.f * (1.f - powf(pascal / 101325.f, 1.f / 5.255f));
 
         usb_talk_publish_barometer(_device_address, param->channel, &pascal, &meter);
-
-        param->value = pascal;
-        param->next_pub = twr_scheduler_get_spin_tick() + BAROMETER_TAG_PUB_NO_CHANGE_INTEVAL;
     }
+
+    stats_task(STATS_TASK_BAROMETER_TAG, start);
 }
 
 void barometer_tag_init(twr_i2c_channel_t i2c_channel, barometer_tag_t *tag)
@@ -230,9 +372,11 @@ void barometer_tag_init(twr_i2c_channel_t i2c_channel, barometer_tag_t *tag)
 
     tag->param.channel = TWR_RADIO_PUB_CHANNEL_R1_I2C0_ADDRESS_DEFAULT;
 
+    _sensors_register("barometer-tag", i2c_channel, 0x60, &tag->param, CONFIG_KEY_BAROMETER_INTERVAL, _sensors_measure_barometer, &tag->self);
+
     twr_tag_barometer_init(&tag->self, i2c_channel);
 
-    twr_tag_barometer_set_update_interval(&tag->self, BAROMETER_TAG_UPDATE_INTERVAL);
+    twr_tag_barometer_set_update_interval(&tag->self, TWR_TICK_INFINITY);
 
     twr_tag_barometer_set_event_handler(&tag->self, barometer_tag_event_handler, &tag->param);
 }
@@ -242,25 +386,40 @@ void co2_event_handler(twr_module_co2_event_t event, void *event_param)
     event_param_t *param = (event_param_t *) event_param;
     float value;
 
-    if (event == TWR_MODULE_CO2_EVENT_UPDATE)
+    if (event == TWR_MODULE_CO2_EVENT_ERROR)
     {
+        if (_sensors_presence(param, false))
+        {
+            twr_module_co2_set_update_interval(param->interval);
+        }
+    }
+    else if (event == TWR_MODULE_CO2_EVENT_UPDATE)
+    {
+        stats_mark_t start = stats_mark();
+
+        if (_sensors_presence(param, true))
+        {
+            twr_module_co2_set_update_interval(param->interval);
+        }
+
         if (twr_module_co2_get_concentration_ppm(&value))
         {
-            if ((fabs(value - param->value) >= CO2_PUB_VALUE_CHANGE) || (param->next_pub < twr_scheduler_get_spin_tick()))
+            if (_sensors_filter(param, SENSORS_CLASS_CO2, &value))
             {
                 usb_talk_publish_co2(_device_address, &value);
-                param->value = value;
-                param->next_pub = twr_scheduler_get_spin_tick() + CO2_PUB_NO_CHANGE_INTERVAL;
             }
         }
+
+        stats_task(STATS_TASK_CO2_MODULE, start);
     }
 }
 
 void co2_module_init(void)
 {
     static event_param_t event_param = { .next_pub = 0 };
+    _sensors_register("co2-module", TWR_I2C_I2C0, 0, &event_param, CONFIG_KEY_CO2_INTERVAL, NULL, NULL);
     twr_module_co2_init();
-    twr_module_co2_set_update_interval(CO2_UPDATE_INTERVAL);
+    twr_module_co2_set_update_interval(event_param.interval);
     twr_module_co2_set_event_handler(co2_event_handler, &event_param);
 }
 
@@ -271,9 +430,11 @@ static void pir_event_handler(twr_module_pir_t *self, twr_module_pir_event_t eve
 
     if (event == TWR_MODULE_PIR_EVENT_MOTION)
     {
+        stats_mark_t start = stats_mark();
         static uint16_t event_count = 0;
         event_count++;
         usb_talk_publish_event_count(_device_address, "pir", &event_count);
+        stats_task(STATS_TASK_PIR_MODULE, start);
     }
 }
 
@@ -284,3 +445,299 @@ void pir_module_init(void)
     twr_module_pir_set_event_handler(&pir, pir_event_handler, NULL);
 }
 
+
+void sensors_list(void)
+{
+    usb_talk_message_start("/stats/sensors");
+
+    usb_talk_message_array_begin();
+
+    for (int i = 0; i < _sensors.length; i++)
+    {
+        sensors_entry_t *entry = &_sensors.entry[i];
+
+        usb_talk_message_object_begin();
+
+        usb_talk_message_key("name");
+
+        usb_talk_message_string(entry->name);
+
+        usb_talk_message_key("i2c");
+
+        usb_talk_message_uint(entry->i2c_channel == TWR_I2C_I2C0 ? 0 : 1);
+
+        if (entry->i2c_address != 0)
+        {
+            usb_talk_message_key("address");
+
+            usb_talk_message_uint(entry->i2c_address);
+        }
+
+        usb_talk_message_key("present");
+
+        usb_talk_message_bool(entry->param->present);
+
+        usb_talk_message_key("errors");
+
+        usb_talk_message_uint(entry->param->errors);
+
+        usb_talk_message_key("interval");
+
+        usb_talk_message_uint(entry->param->interval);
+
+        usb_talk_message_object_end();
+    }
+
+    usb_talk_message_array_end();
+
+    usb_talk_message_send();
+}
+
+void sensors_update_intervals(void)
+{
+    if (_sensors.length == 0)
+    {
+        // Radio Dongle or before the sensors are set up
+        return;
+    }
+
+    for (int i = 0; i < _sensors.length; i++)
+    {
+        sensors_entry_t *entry = &_sensors.entry[i];
+
+        twr_tick_t update_interval = config_get_int(entry->interval_key);
+
+        if (update_interval == entry->param->update_interval)
+        {
+            continue;
+        }
+
+        entry->param->update_interval = update_interval;
+
+        // An absent tag keeps backing off, from the new interval on its next failure
+        if (entry->param->errors == 0)
+        {
+            entry->param->interval = update_interval;
+        }
+
+        // The CO2 module is the only one with its own timer
+        if (entry->measure == NULL)
+        {
+            twr_module_co2_set_update_interval(entry->param->interval);
+        }
+    }
+
+    _sensors_burst_plan();
+}
+
+static void _sensors_register(const char *name, twr_i2c_channel_t i2c_channel, uint8_t i2c_address, event_param_t *param, config_key_t interval_key, bool (*measure)(void *self), void *self)
+{
+    param->update_interval = config_get_int(interval_key);
+    param->interval = param->update_interval;
+
+    if (_sensors.length >= SENSORS_LENGTH)
+    {
+        return;
+    }
+
+    sensors_entry_t *entry = &_sensors.entry[_sensors.length++];
+
+    entry->name = name;
+    entry->i2c_channel = i2c_channel;
+    entry->i2c_address = i2c_address;
+    entry->param = param;
+    entry->interval_key = interval_key;
+    entry->measure = measure;
+    entry->self = self;
+    entry->measure_tick = 0;
+}
+
+// Returns true when the driver has to be given the new interval
+static bool _sensors_presence(event_param_t *param, bool present)
+{
+    twr_tick_t interval = param->update_interval;
+
+    if (present)
+    {
+        param->present = true;
+        param->errors = 0;
+    }
+    else
+    {
+        param->present = false;
+
+        if (param->errors < UINT16_MAX)
+        {
+            param->errors++;
+        }
+
+        // Doubles with each failure in a row
+        for (int i = 0; (i < param->errors) && (interval < SENSORS_PROBE_INTERVAL_MAX); i++)
+        {
+            interval *= 2;
+        }
+
+        if ((interval > SENSORS_PROBE_INTERVAL_MAX) && (param->update_interval < SENSORS_PROBE_INTERVAL_MAX))
+        {
+            interval = SENSORS_PROBE_INTERVAL_MAX;
+        }
+    }
+
+    if (interval == param->interval)
+    {
+        return false;
+    }
+
+    param->interval = interval;
+
+    return true;
+}
+
+// Returns true with the value to publish, smoothed or the raw sample when the rate triggered
+static bool _sensors_filter(event_param_t *param, sensors_class_t sensors_class, float *value)
+{
+    const sensors_filter_keys_t *keys = &_sensors_filter_keys[sensors_class];
+
+    twr_tick_t now = twr_scheduler_get_spin_tick();
+
+    if (isnan(*value))
+    {
+        return false;
+    }
+
+    bool first = param->sample_tick == 0;
+
+    bool rate = false;
+
+    if (first)
+    {
+        param->smoothed = *value;
+    }
+    else
+    {
+        float rate_limit = config_get_float(keys->rate);
+
+        if ((rate_limit > 0.f) && (now > param->sample_tick))
+        {
+            rate = (fabsf(*value - param->sample) * 1000.f / (float) (now - param->sample_tick)) >= rate_limit;
+        }
+
+        // A fast move skips the smoothing lag
+        param->smoothed = rate ? *value : param->smoothed + (config_get_float(keys->smoothing) * (*value - param->smoothed));
+    }
+
+    param->sample = *value;
+    param->sample_tick = now;
+
+    if (!first)
+    {
+        float change = config_get_float(keys->change);
+
+        float difference = param->smoothed - param->value;
+
+        int8_t direction = difference < 0.f ? -1 : 1;
+
+        // Noise around the threshold does not flip the value back and forth
+        if ((param->direction != 0) && (direction != param->direction))
+        {
+            change += change * config_get_float(keys->hysteresis);
+        }
+
+        bool changed = fabsf(difference) >= change;
+
+        if (!changed && !rate && (param->next_pub > now))
+        {
+            return false;
+        }
+
+        if (now < param->last_pub + config_get_int(keys->min_interval))
+        {
+            return false;
+        }
+
+        param->direction = difference == 0.f ? param->direction : direction;
+    }
+
+    param->value = param->smoothed;
+    param->last_pub = now;
+    param->next_pub = now + config_get_int(keys->no_change_interval);
+
+    *value = param->smoothed;
+
+    return true;
+}
+
+static void _sensors_burst_task(void *param)
+{
+    sensors_bus_t *bus = (sensors_bus_t *) param;
+
+    twr_tick_t now = twr_scheduler_get_spin_tick();
+
+    // Late runs still count from the boundary, so the phases stay aligned
+    twr_tick_t tick = now - (now % SENSORS_BURST_PERIOD);
+
+    twr_tick_t next = TWR_TICK_INFINITY;
+
+    for (int i = 0; i < _sensors.length; i++)
+    {
+        sensors_entry_t *entry = &_sensors.entry[i];
+
+        if ((entry->measure == NULL) || (entry->i2c_channel != bus->i2c_channel))
+        {
+            continue;
+        }
+
+        // Follows interval changes made since the last burst
+        if ((entry->measure_tick == 0) || (entry->measure_tick + entry->param->interval <= tick))
+        {
+            entry->measure(entry->self);
+
+            entry->measure_tick = tick;
+        }
+
+        if (entry->measure_tick + entry->param->interval < next)
+        {
+            next = entry->measure_tick + entry->param->interval;
+        }
+    }
+
+    if (next != TWR_TICK_INFINITY)
+    {
+        // Intervals that are not a multiple of the period are rounded up
+        twr_scheduler_plan_current_absolute(_sensors_burst_align(next));
+    }
+}
+
+static void _sensors_burst_plan(void)
+{
+    // A shorter interval may be due before the bursts planned so far
+    for (int i = 0; i < SENSORS_BUS_COUNT; i++)
+    {
+        twr_scheduler_plan_now(_sensors.bus[i].task_id);
+    }
+}
+
+static twr_tick_t _sensors_burst_align(twr_tick_t tick)
+{
+    return ((tick + SENSORS_BURST_PERIOD - 1) / SENSORS_BURST_PERIOD) * SENSORS_BURST_PERIOD;
+}
+
+static bool _sensors_measure_temperature(void *self)
+{
+    return twr_tag_temperature_measure((twr_tag_temperature_t *) self);
+}
+
+static bool _sensors_measure_humidity(void *self)
+{
+    return twr_tag_humidity_measure((twr_tag_humidity_t *) self);
+}
+
+static bool _sensors_measure_lux_meter(void *self)
+{
+    return twr_tag_lux_meter_measure((twr_tag_lux_meter_t *) self);
+}
+
+static bool _sensors_measure_barometer(void *self)
+{
+    return twr_tag_barometer_measure((twr_tag_barometer_t *) self);
+}
@@ -3,33 +3,92 @@
 
 #include <twr_common.h>
 #include <bcl.h>
+#include <config.h>
 
 #define TEMPERATURE_TAG_PUB_NO_CHANGE_INTEVAL (5 * 60 * 1000)
 #define TEMPERATURE_TAG_PUB_VALUE_CHANGE 0.1f
 #define TEMPERATURE_TAG_UPDATE_INTERVAL (1 * 1000)
+#define TEMPERATURE_TAG_PUB_SMOOTHING 1.0f
+#define TEMPERATURE_TAG_PUB_MIN_INTERVAL 0
 
 #define HUMIDITY_TAG_PUB_NO_CHANGE_INTEVAL (5 * 60 * 1000)
 #define HUMIDITY_TAG_PUB_VALUE_CHANGE 1.0f
 #define HUMIDITY_TAG_UPDATE_INTERVAL (1 * 1000)
+#define HUMIDITY_TAG_PUB_SMOOTHING 1.0f
+#define HUMIDITY_TAG_PUB_MIN_INTERVAL 0
 
 #define LUX_METER_TAG_PUB_NO_CHANGE_INTEVAL (5 * 60 * 1000)
 #define LUX_METER_TAG_PUB_VALUE_CHANGE 5.0f
 #define LUX_METER_TAG_UPDATE_INTERVAL (1 * 1000)
+#define LUX_METER_TAG_PUB_SMOOTHING 0.3f
+#define LUX_METER_TAG_PUB_MIN_INTERVAL (5 * 1000)
 
 #define BAROMETER_TAG_PUB_NO_CHANGE_INTEVAL (5 * 60 * 1000)
 #define BAROMETER_TAG_PUB_VALUE_CHANGE 10.0f
 #define BAROMETER_TAG_UPDATE_INTERVAL (1 * 1000)
+#define BAROMETER_TAG_PUB_SMOOTHING 0.5f
+#define BAROMETER_TAG_PUB_MIN_INTERVAL 0
 
 #define CO2_PUB_NO_CHANGE_INTERVAL (5 * 60 * 1000)
 #define CO2_PUB_VALUE_CHANGE 50.0f
 #define CO2_UPDATE_INTERVAL (15 * 1000)
+#define CO2_UPDATE_INTERVAL_MIN (5 * 1000)
+#define CO2_PUB_SMOOTHING 0.5f
+#define CO2_PUB_MIN_INTERVAL 0
+
+// Share of the change needed on top to publish a move back against the last one
+#define SENSORS_PUB_HYSTERESIS 0.5f
+// Change per second that publishes the raw sample at once, zero turns it off
+#define SENSORS_PUB_RATE 0.f
+
+// Defaults above, the values in use are set at runtime through the config store
+#define SENSORS_INTERVAL_MAX (60 * 60 * 1000)
+#define SENSORS_NO_CHANGE_INTERVAL_MAX (24 * 60 * 60 * 1000)
+
+// Absent tags are retried at twice the interval after each failure up to this, hot-plugged ones show up within it
+#ifndef SENSORS_PROBE_INTERVAL_MAX
+#define SENSORS_PROBE_INTERVAL_MAX (60 * 1000)
+#endif
+#define SENSORS_LENGTH 17
+
+// Tags are measured together in bursts on multiples of this, one burst task per I2C bus
+#ifndef SENSORS_BURST_PERIOD
+#define SENSORS_BURST_PERIOD (1 * 1000)
+#endif
+#define SENSORS_BUS_COUNT 2
+
+typedef enum
+{
+    SENSORS_CLASS_TEMPERATURE = 0,
+    SENSORS_CLASS_HUMIDITY = 1,
+    SENSORS_CLASS_LUX_METER = 2,
+    SENSORS_CLASS_BAROMETER = 3,
+    SENSORS_CLASS_CO2 = 4,
+
+    SENSORS_CLASS_COUNT = 5
+
+} sensors_class_t;
 
 typedef struct
 {
     uint8_t channel;
+    // Last published value, its direction and time
     float value;
+    int8_t direction;
+    twr_tick_t last_pub;
     twr_tick_t next_pub;
 
+    // Smoothed value, last raw sample and its time, zero before the first one
+    float smoothed;
+    float sample;
+    twr_tick_t sample_tick;
+
+    // Interval while present and the one in use
+    twr_tick_t update_interval;
+    twr_tick_t interval;
+    uint16_t errors;
+    bool present;
+
 } event_param_t;
 
 typedef struct
@@ -74,4 +133,8 @@ void co2_module_init(void);
 
 void pir_module_init(void);
 
+void sensors_list(void);
+
+void sensors_update_intervals(void);
+
 #endif
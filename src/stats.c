@@ -0,0 +1,338 @@
+#include <stats.h>
+#include <usb_talk.h>
+#include <twr_timer.h>
+
+static const char *_stats_event_name[STATS_EVENT_COUNT] = {
+    [STATS_EVENT_NONE] = "none",
+    [STATS_EVENT_EVENT_COUNT] = "event-count",
+    [STATS_EVENT_THERMOMETER] = "thermometer",
+    [STATS_EVENT_HYGROMETER] = "hygrometer",
+    [STATS_EVENT_LUX_METER] = "lux-meter",
+    [STATS_EVENT_BAROMETER] = "barometer",
+    [STATS_EVENT_CO2_METER] = "co2-meter",
+    [STATS_EVENT_BATTERY] = "battery",
+    [STATS_EVENT_STATE] = "state",
+    [STATS_EVENT_VALUE] = "value",
+    [STATS_EVENT_ACCELEROMETER] = "accelerometer",
+    [STATS_EVENT_BUFFER] = "buffer",
+    [STATS_EVENT_INFO] = "info",
+    [STATS_EVENT_GENERIC] = "generic"
+};
+
+static const char *_stats_task_name[STATS_TASK_COUNT] = {
+    [STATS_TASK_USB_TALK] = "usb-talk",
+    [STATS_TASK_RADIO] = "radio",
+    [STATS_TASK_BATCH] = "batch",
+    [STATS_TASK_APPLICATION] = "application",
+    [STATS_TASK_TEMPERATURE_TAG] = "temperature-tag",
+    [STATS_TASK_HUMIDITY_TAG] = "humidity-tag",
+    [STATS_TASK_LUX_METER_TAG] = "lux-meter-tag",
+    [STATS_TASK_BAROMETER_TAG] = "barometer-tag",
+    [STATS_TASK_CO2_MODULE] = "co2-module",
+    [STATS_TASK_PIR_MODULE] = "pir-module",
+    [STATS_TASK_CONFIG] = "config"
+};
+
+static struct
+{
+    // Saturating counters, a histogram fits in 24 bytes
+    uint16_t latency[STATS_EVENT_COUNT][STATS_LATENCY_BUCKETS];
+
+    struct
+    {
+        uint32_t runs;
+        uint64_t microseconds;
+
+    } task[STATS_TASK_COUNT];
+
+    twr_tick_t task_since;
+
+    struct
+    {
+        uint32_t *bottom;
+        // Lowest word found overwritten so far
+        uint32_t *low;
+
+        const char *handler;
+        size_t handler_peak;
+
+    } stack;
+
+} _stats;
+
+#define STATS_STACK_PATTERN 0xa5a5a5a5
+
+// Provided by the linker script
+extern uint32_t _ebss;
+extern uint32_t _estack;
+
+static uint32_t *_stats_stack_low(void);
+
+void stats_latency(stats_event_t event, twr_tick_t latency)
+{
+    if ((event == STATS_EVENT_NONE) || (event >= STATS_EVENT_COUNT))
+    {
+        return;
+    }
+
+    int bucket = 0;
+
+    while ((latency != 0) && (bucket < STATS_LATENCY_BUCKETS - 1))
+    {
+        latency >>= 1;
+
+        bucket++;
+    }
+
+    if (_stats.latency[event][bucket] != UINT16_MAX)
+    {
+        _stats.latency[event][bucket]++;
+    }
+}
+
+void stats_latency_reset(void)
+{
+    memset(_stats.latency, 0, sizeof(_stats.latency));
+}
+
+void stats_latency_list(void)
+{
+    usb_talk_message_start("/stats/latency");
+
+    usb_talk_message_object_begin();
+
+    for (int i = STATS_EVENT_NONE + 1; i < STATS_EVENT_COUNT; i++)
+    {
+        uint32_t sum = 0;
+
+        for (int j = 0; j < STATS_LATENCY_BUCKETS; j++)
+        {
+            sum += _stats.latency[i][j];
+        }
+
+        if (sum == 0)
+        {
+            continue;
+        }
+
+        usb_talk_message_key(_stats_event_name[i]);
+
+        usb_talk_message_array_begin();
+
+        for (int j = 0; j < STATS_LATENCY_BUCKETS; j++)
+        {
+            usb_talk_message_uint(_stats.latency[i][j]);
+        }
+
+        usb_talk_message_array_end();
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+void stats_init(void)
+{
+    // Free running from here on, handlers take well under a millisecond and ticks would read 0
+    twr_timer_init();
+
+    twr_timer_start();
+}
+
+stats_mark_t stats_mark(void)
+{
+    stats_mark_t mark = {
+        .tick = twr_tick_get(),
+        .microseconds = (uint16_t) twr_timer_get_microseconds()
+    };
+
+    return mark;
+}
+
+void stats_task(stats_task_t task, stats_mark_t start)
+{
+    stats_mark_t now = stats_mark();
+
+    twr_tick_t ticks = now.tick - start.tick;
+
+    _stats.task[task].runs++;
+
+    // Tick and timer are read apart, a margin below the 65 ms wrap keeps the difference unambiguous
+    if (ticks < 60)
+    {
+        _stats.task[task].microseconds += (uint16_t) (now.microseconds - start.microseconds);
+    }
+    else
+    {
+        _stats.task[task].microseconds += (uint64_t) ticks * 1000;
+    }
+}
+
+void stats_task_reset(void)
+{
+    memset(_stats.task, 0, sizeof(_stats.task));
+
+    _stats.task_since = twr_tick_get();
+}
+
+void stats_task_list(void)
+{
+    bool listed[STATS_TASK_COUNT] = { false };
+
+    usb_talk_message_start("/stats/tasks");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("period");
+
+    usb_talk_message_uint64(twr_tick_get() - _stats.task_since);
+
+    usb_talk_message_key("tasks");
+
+    usb_talk_message_array_begin();
+
+    // Top consumers first
+    while (true)
+    {
+        int top = -1;
+
+        for (int i = 0; i < STATS_TASK_COUNT; i++)
+        {
+            if (listed[i] || (_stats.task[i].runs == 0))
+            {
+                continue;
+            }
+
+            if ((top < 0) || (_stats.task[i].microseconds > _stats.task[top].microseconds))
+            {
+                top = i;
+            }
+        }
+
+        if (top < 0)
+        {
+            break;
+        }
+
+        listed[top] = true;
+
+        usb_talk_message_object_begin();
+
+        usb_talk_message_key("name");
+
+        usb_talk_message_string(_stats_task_name[top]);
+
+        usb_talk_message_key("runs");
+
+        usb_talk_message_uint(_stats.task[top].runs);
+
+        usb_talk_message_key("microseconds");
+
+        usb_talk_message_uint64(_stats.task[top].microseconds);
+
+        usb_talk_message_object_end();
+    }
+
+    usb_talk_message_array_end();
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+void stats_stack_paint(void)
+{
+    volatile uint32_t marker = 0;
+
+    // Keep clear of the frame of this function
+    uint32_t *top = (uint32_t *) &marker - 16;
+
+    _stats.stack.bottom = (uint32_t *) (((uintptr_t) &_ebss + STATS_STACK_HEAP_RESERVE + 3) & ~(uintptr_t) 3);
+
+    // Plain loop, a library call would run its own frame in the painted area
+    for (volatile uint32_t *p = _stats.stack.bottom; p < top; p++)
+    {
+        *p = STATS_STACK_PATTERN;
+    }
+
+    _stats.stack.low = top;
+
+    (void) marker;
+}
+
+void stats_stack_probe(const char *handler)
+{
+    if (_stats.stack.bottom == NULL)
+    {
+        return;
+    }
+
+    uint32_t *low = _stats_stack_low();
+
+    if (low >= _stats.stack.low)
+    {
+        return;
+    }
+
+    _stats.stack.low = low;
+
+    // Handler that pushed the mark down, NULL when it moved before the handler ran
+    if (handler != NULL)
+    {
+        _stats.stack.handler = handler;
+        _stats.stack.handler_peak = (uintptr_t) &_estack - (uintptr_t) low;
+    }
+}
+
+void stats_stack_list(void)
+{
+    stats_stack_probe(NULL);
+
+    usb_talk_message_start("/stats/stack");
+
+    usb_talk_message_object_begin();
+
+    if (_stats.stack.bottom != NULL)
+    {
+        usb_talk_message_key("size");
+
+        usb_talk_message_uint((uintptr_t) &_estack - (uintptr_t) _stats.stack.bottom);
+
+        usb_talk_message_key("peak");
+
+        usb_talk_message_uint((uintptr_t) &_estack - (uintptr_t) _stats.stack.low);
+
+        usb_talk_message_key("free");
+
+        usb_talk_message_uint((uintptr_t) _stats.stack.low - (uintptr_t) _stats.stack.bottom);
+
+        if (_stats.stack.handler != NULL)
+        {
+            usb_talk_message_key("handler");
+
+            usb_talk_message_string(_stats.stack.handler);
+
+            usb_talk_message_key("handler-peak");
+
+            usb_talk_message_uint(_stats.stack.handler_peak);
+        }
+    }
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+static uint32_t *_stats_stack_low(void)
+{
+    // Search up from the bottom, a frame may leave parts of its arrays untouched
+    uint32_t *p = _stats.stack.bottom;
+
+    while ((p < _stats.stack.low) && (*p == STATS_STACK_PATTERN))
+    {
+        p++;
+    }
+
+    return p;
+}
@@ -0,0 +1,87 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <twr_common.h>
+#include <twr_tick.h>
+
+// Bucket 0 counts 0 ms, bucket n counts 2^(n-1) to 2^n - 1 ms, the last one everything above
+#define STATS_LATENCY_BUCKETS 12
+
+typedef enum
+{
+    STATS_EVENT_NONE = 0,
+    STATS_EVENT_EVENT_COUNT = 1,
+    STATS_EVENT_THERMOMETER = 2,
+    STATS_EVENT_HYGROMETER = 3,
+    STATS_EVENT_LUX_METER = 4,
+    STATS_EVENT_BAROMETER = 5,
+    STATS_EVENT_CO2_METER = 6,
+    STATS_EVENT_BATTERY = 7,
+    STATS_EVENT_STATE = 8,
+    STATS_EVENT_VALUE = 9,
+    STATS_EVENT_ACCELEROMETER = 10,
+    STATS_EVENT_BUFFER = 11,
+    STATS_EVENT_INFO = 12,
+    // Generic bool, int, float, uint32 and string values
+    STATS_EVENT_GENERIC = 13,
+
+    STATS_EVENT_COUNT = 14
+
+} stats_event_t;
+
+typedef enum
+{
+    // Serial input, command parsing and handlers
+    STATS_TASK_USB_TALK = 0,
+    // Radio callbacks up to the last line written
+    STATS_TASK_RADIO = 1,
+    STATS_TASK_BATCH = 2,
+    STATS_TASK_APPLICATION = 3,
+    STATS_TASK_TEMPERATURE_TAG = 4,
+    STATS_TASK_HUMIDITY_TAG = 5,
+    STATS_TASK_LUX_METER_TAG = 6,
+    STATS_TASK_BAROMETER_TAG = 7,
+    STATS_TASK_CO2_MODULE = 8,
+    STATS_TASK_PIR_MODULE = 9,
+    STATS_TASK_CONFIG = 10,
+
+    STATS_TASK_COUNT = 11
+
+} stats_task_t;
+
+// Start of a task run, the microsecond timer wraps after 65 ms so longer runs fall back to ticks
+typedef struct
+{
+    twr_tick_t tick;
+    uint16_t microseconds;
+
+} stats_mark_t;
+
+// Space above the bss left unpainted for the C library heap
+#ifndef STATS_STACK_HEAP_RESERVE
+#define STATS_STACK_HEAP_RESERVE 1024
+#endif
+
+void stats_latency(stats_event_t event, twr_tick_t latency);
+
+void stats_latency_reset(void);
+
+void stats_latency_list(void);
+
+void stats_init(void);
+
+stats_mark_t stats_mark(void);
+
+void stats_task(stats_task_t task, stats_mark_t start);
+
+void stats_task_reset(void);
+
+void stats_task_list(void);
+
+void stats_stack_paint(void);
+
+void stats_stack_probe(const char *handler);
+
+void stats_stack_list(void);
+
+#endif // _STATS_H
@@ -0,0 +1,27 @@
+#include <timesync.h>
+
+static struct
+{
+    bool synced;
+    // Host time in ms at gateway tick zero
+    uint64_t offset;
+
+} _timesync;
+
+void timesync_set(uint64_t time)
+{
+    _timesync.offset = time - twr_tick_get();
+
+    _timesync.synced = true;
+}
+
+bool timesync_is_synced(void)
+{
+    return _timesync.synced;
+}
+
+uint64_t timesync_get(twr_tick_t tick)
+{
+    // Gateway ticks until the host sends its time
+    return _timesync.offset + tick;
+}
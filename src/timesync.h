@@ -0,0 +1,13 @@
+#ifndef _TIMESYNC_H
+#define _TIMESYNC_H
+
+#include <twr_common.h>
+#include <twr_tick.h>
+
+void timesync_set(uint64_t time);
+
+bool timesync_is_synced(void);
+
+uint64_t timesync_get(twr_tick_t tick);
+
+#endif // _TIMESYNC_H
@@ -4,15 +4,46 @@
 #include <twr_radio_pub.h>
 #include <twr_base64.h>
 #include <application.h>
+#include <precision.h>
+#include <retained.h>
+#include <crc.h>
+#include <timesync.h>
+#include <stats.h>
+#include <eeprom.h>
 
 #define USB_TALK_MAX_TOKENS 100
 
+#define USB_TALK_MESSAGE_MAX_DEPTH 8
+// Longest number or quoted node id written by the message writer
+#define USB_TALK_NUMBER_MAX_LENGTH 24
+// Topic formatted by the publishers, without the node id prefix
+#define USB_TALK_TOPIC_MAX_LENGTH 64
+// Event lines waiting for the UART write FIFO to drain
+#define USB_TALK_TX_PENDING_LENGTH 16
+
 #define USB_TALK_TOKEN_ARRAY         0
 #define USB_TALK_TOKEN_TOPIC         1
 #define USB_TALK_TOKEN_PAYLOAD       2
 #define USB_TALK_TOKEN_PAYLOAD_KEY   3
 #define USB_TALK_TOKEN_PAYLOAD_VALUE 4
 
+typedef struct
+{
+    size_t tx_peak;
+    // Long lines sent in more than one chunk
+    uint32_t tx_split;
+    uint32_t tx_truncated;
+    // Writes not taken whole by the CDC driver or the UART write FIFO
+    uint32_t tx_overflow;
+    uint32_t tx_dropped;
+    size_t rx_peak;
+    // Lines longer than rx_buffer
+    uint32_t rx_dropped;
+    size_t write_fifo_peak;
+    size_t read_fifo_peak;
+
+} usb_talk_buffers_t;
+
 static struct
 {
     char tx_buffer[512];
@@ -21,6 +52,10 @@ static struct
     size_t tx_length;
     bool rx_error;
 
+    uint8_t tx_depth;
+    uint8_t tx_first;
+    bool tx_key;
+
     const usb_talk_subscribe_t *subscribes;
     int subscribes_length;
 
@@ -30,12 +65,34 @@ static struct
 
     bool read_start;
 
+    usb_talk_buffer_format_t buffer_format;
+
+    bool envelope;
+    uint32_t tx_sequence;
+    uint16_t tx_crc;
+
+    usb_talk_buffers_t buffers;
+
+    bool timestamp;
+    stats_event_t event;
+    twr_tick_t event_tick;
+    stats_mark_t event_mark;
+    twr_tick_t event_spin;
+
 #if TALK_OVER_CDC
 #else
     uint8_t read_fifo_buffer[1024];
     twr_fifo_t read_fifo;
     uint8_t write_fifo_buffer[1024];
     twr_fifo_t write_fifo;
+
+    struct
+    {
+        stats_event_t event;
+        twr_tick_t tick;
+
+    } tx_pending[USB_TALK_TX_PENDING_LENGTH];
+    int tx_pending_length;
 #endif
 
 } _usb_talk;
@@ -49,15 +106,39 @@ static void _usb_talk_read_start(void);
 static void _usb_talk_process_character(char character);
 static void _usb_talk_process_message(char *message, size_t length);
 static bool _usb_talk_token_get_int(const char *buffer, jsmntok_t *token, int *value);
+static bool _usb_talk_token_get_uint64(const char *buffer, jsmntok_t *token, uint64_t *value);
 static bool _usb_talk_token_get_float(const char *buffer, jsmntok_t *token, float *value);
 static bool _usb_talk_token_get_string(const char *buffer, jsmntok_t *token, char *str, size_t *length);
 static bool _usb_talk_payload_get_node_id(const char *buffer, jsmntok_t *token, uint64_t *value);
 static bool _usb_talk_payload_get_color(const char *buffer, jsmntok_t *token, uint32_t *color);
+static void _usb_talk_write(const char *buffer, size_t length);
+static void _usb_talk_write_envelope(const char *buffer, size_t length);
+static void _usb_talk_transport(const char *buffer, size_t length);
+static bool _usb_talk_event_is_valid(void);
+#if !TALK_OVER_CDC
+static size_t _usb_talk_fifo_length(twr_fifo_t *fifo);
+#endif
+static void _usb_talk_message_begin(void);
+static void _usb_talk_message_topic(const char *topic, va_list ap);
+static void _usb_talk_message_flush(void);
+static char *_usb_talk_message_reserve(size_t length);
+static void _usb_talk_message_write(const char *buffer, size_t length);
+static void _usb_talk_message_separator(void);
+static void _usb_talk_message_container_begin(char character);
+static void _usb_talk_message_container_end(char character);
+static void _usb_talk_message_string(const char *str);
+static size_t _usb_talk_uint_to_str(char *str, uint32_t value);
+static size_t _usb_talk_uint64_to_str(char *str, uint64_t value);
+static size_t _usb_talk_node_id_to_str(char *str, uint64_t value);
+static size_t _usb_talk_float_to_str(char *str, float value, int decimals);
+static void _usb_talk_publish_float(uint64_t *device_address, const char *topic, float *value, precision_class_t precision_class);
 
 void usb_talk_init(void)
 {
     memset(&_usb_talk, 0, sizeof(_usb_talk));
 
+    _usb_talk.buffer_format = USB_TALK_BUFFER_FORMAT;
+
 #if TALK_OVER_CDC
     twr_usb_cdc_init();
 #else
@@ -120,43 +201,224 @@ bool usb_talk_add_sub(const char *topic, usb_talk_sub_callback_t callback, uint8
 
 void usb_talk_send_string(const char *buffer)
 {
-#if TALK_OVER_CDC
-    twr_usb_cdc_write(buffer, strlen(buffer));
-#else
-    twr_uart_async_write(TWR_UART_UART2, buffer, strlen(buffer));
-#endif
+    _usb_talk_write(buffer, strlen(buffer));
 }
 
 void usb_talk_send_format(const char *format, ...)
 {
     va_list ap;
-    size_t length;
+    int length;
 
     va_start(ap, format);
     length = vsnprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer), format, ap);
     va_end(ap);
 
+    if (length < 0)
+    {
+        return;
+    }
+
+    if ((size_t) length >= sizeof(_usb_talk.tx_buffer))
+    {
+        // A cut line has no line end and is not valid JSON, it is dropped and leaves a gap in the sequence
+        _usb_talk.buffers.tx_truncated++;
+
+        if (_usb_talk.envelope)
+        {
+            _usb_talk.tx_sequence++;
+        }
+
+        return;
+    }
+
+    if ((size_t) length > _usb_talk.buffers.tx_peak)
+    {
+        _usb_talk.buffers.tx_peak = length;
+    }
+
+    _usb_talk_write(_usb_talk.tx_buffer, length);
+}
+
+void usb_talk_set_buffer_format(usb_talk_buffer_format_t format)
+{
+    _usb_talk.buffer_format = format;
+}
+
+usb_talk_buffer_format_t usb_talk_get_buffer_format(void)
+{
+    return _usb_talk.buffer_format;
+}
+
+void usb_talk_set_envelope(bool enable)
+{
+    _usb_talk.envelope = enable;
+
+    _usb_talk.tx_sequence = 0;
+
+    _usb_talk.tx_crc = CRC16_INIT;
+}
+
+bool usb_talk_get_envelope(void)
+{
+    return _usb_talk.envelope;
+}
+
+void usb_talk_set_timestamp(bool enable)
+{
+    _usb_talk.timestamp = enable;
+}
+
+bool usb_talk_get_timestamp(void)
+{
+    return _usb_talk.timestamp;
+}
+
+void usb_talk_buffers_reset(void)
+{
+    memset(&_usb_talk.buffers, 0, sizeof(_usb_talk.buffers));
+}
+
+void usb_talk_buffers_list(void)
+{
+    // Copy first, the message itself moves the counters
+    usb_talk_buffers_t buffers = _usb_talk.buffers;
+
+    usb_talk_message_start("/stats/buffers");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("tx-buffer");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("size");
+
+    usb_talk_message_uint(sizeof(_usb_talk.tx_buffer));
+
+    usb_talk_message_key("peak");
+
+    usb_talk_message_uint(buffers.tx_peak);
+
+    usb_talk_message_key("split");
+
+    usb_talk_message_uint(buffers.tx_split);
+
+    usb_talk_message_key("truncated");
+
+    usb_talk_message_uint(buffers.tx_truncated);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_key("rx-buffer");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("size");
+
+    usb_talk_message_uint(sizeof(_usb_talk.rx_buffer));
+
+    usb_talk_message_key("peak");
+
+    usb_talk_message_uint(buffers.rx_peak);
+
+    usb_talk_message_key("dropped");
+
+    usb_talk_message_uint(buffers.rx_dropped);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_key("write");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("overflow");
+
+    usb_talk_message_uint(buffers.tx_overflow);
+
+    usb_talk_message_key("dropped");
+
+    usb_talk_message_uint(buffers.tx_dropped);
+
+    usb_talk_message_object_end();
+
+#if !TALK_OVER_CDC
+    usb_talk_message_key("write-fifo");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("size");
+
+    usb_talk_message_uint(sizeof(_usb_talk.write_fifo_buffer));
+
+    usb_talk_message_key("peak");
+
+    usb_talk_message_uint(buffers.write_fifo_peak);
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_key("read-fifo");
+
+    usb_talk_message_object_begin();
+
+    usb_talk_message_key("size");
+
+    usb_talk_message_uint(sizeof(_usb_talk.read_fifo_buffer));
+
+    usb_talk_message_key("peak");
+
+    usb_talk_message_uint(buffers.read_fifo_peak);
+
+    usb_talk_message_object_end();
+#endif
+
+    usb_talk_message_object_end();
+
+    usb_talk_message_send();
+}
+
+void usb_talk_event_begin(stats_event_t event)
+{
+    _usb_talk.event = event;
+
+    _usb_talk.event_tick = twr_tick_get();
+
+    _usb_talk.event_mark = stats_mark();
+
+    _usb_talk.event_spin = twr_scheduler_get_spin_tick();
+}
+
+bool usb_talk_is_tx_ready(void)
+{
 #if TALK_OVER_CDC
-    twr_usb_cdc_write(_usb_talk.tx_buffer, length);
+    // The CDC driver does not tell its free space, a write that does not fit is counted as overflow
+    return true;
 #else
-    twr_uart_async_write(TWR_UART_UART2, _usb_talk.tx_buffer, length);
+    // One slot of the FIFO always stays empty
+    size_t space = sizeof(_usb_talk.write_fifo_buffer) - 1 - _usb_talk_fifo_length(&_usb_talk.write_fifo);
+
+    return space >= sizeof(_usb_talk.tx_buffer);
 #endif
 }
 
+twr_tick_t usb_talk_get_event_tick(void)
+{
+    if (_usb_talk_event_is_valid())
+    {
+        return _usb_talk.event_tick;
+    }
+
+    return twr_tick_get();
+}
 
 void usb_talk_message_start(const char *topic, ...)
 {
     va_list ap;
 
-    va_start(ap, topic);
-
-    strcpy(_usb_talk.tx_buffer, "[\"");
+    _usb_talk_message_begin();
 
-    _usb_talk.tx_length = 2 + vsnprintf(_usb_talk.tx_buffer + 2, sizeof(_usb_talk.tx_buffer) - 2, topic, ap);
-
-    strcpy(_usb_talk.tx_buffer + _usb_talk.tx_length, "\", ");
+    va_start(ap, topic);
 
-    _usb_talk.tx_length += 3;
+    _usb_talk_message_topic(topic, ap);
 
     va_end(ap);
 }
@@ -165,19 +427,15 @@ void usb_talk_message_start_id(uint64_t *device_address, const char *topic, ...)
 {
     va_list ap;
 
-    strcpy(_usb_talk.tx_buffer, "[\"");
+    _usb_talk_message_begin();
 
-    _usb_talk.tx_length = 2 + snprintf(_usb_talk.tx_buffer + 2, sizeof(_usb_talk.tx_buffer) - 2, USB_TALK_DEVICE_ADDRESS, *device_address);
+    _usb_talk.tx_length += _usb_talk_node_id_to_str(_usb_talk.tx_buffer + _usb_talk.tx_length, *device_address);
 
     _usb_talk.tx_buffer[_usb_talk.tx_length++] = '/';
 
     va_start(ap, topic);
 
-    _usb_talk.tx_length += vsnprintf(_usb_talk.tx_buffer + _usb_talk.tx_length, sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length, topic, ap);
-
-    strcpy(_usb_talk.tx_buffer + _usb_talk.tx_length, "\", ");
-
-    _usb_talk.tx_length += 3;
+    _usb_talk_message_topic(topic, ap);
 
     va_end(ap);
 }
@@ -186,43 +444,198 @@ void usb_talk_message_append(const char *format, ...)
 {
     va_list ap;
 
+    size_t space = sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length;
+
     va_start(ap, format);
 
-    _usb_talk.tx_length += vsnprintf(_usb_talk.tx_buffer + _usb_talk.tx_length, sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length, format, ap);
+    int length = vsnprintf(_usb_talk.tx_buffer + _usb_talk.tx_length, space, format, ap);
 
     va_end(ap);
+
+    if (length < 0)
+    {
+        return;
+    }
+
+    if ((size_t) length >= space)
+    {
+        _usb_talk.buffers.tx_truncated++;
+    }
+
+    _usb_talk.tx_length += ((size_t) length < space) ? (size_t) length : space - 1;
 }
 
 void usb_talk_message_append_float(const char *format, float *value)
 {
     if (value == NULL)
     {
-        strncpy(_usb_talk.tx_buffer + _usb_talk.tx_length, "null", sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length);
+        _usb_talk_message_write("null", 4);
+    }
+    else
+    {
+        usb_talk_message_append(format, *value);
+    }
+}
+
+void usb_talk_message_object_begin(void)
+{
+    _usb_talk_message_container_begin('{');
+}
+
+void usb_talk_message_object_end(void)
+{
+    _usb_talk_message_container_end('}');
+}
+
+void usb_talk_message_array_begin(void)
+{
+    _usb_talk_message_container_begin('[');
+}
+
+void usb_talk_message_array_end(void)
+{
+    _usb_talk_message_container_end(']');
+}
+
+void usb_talk_message_key(const char *key)
+{
+    _usb_talk_message_separator();
+
+    _usb_talk_message_string(key);
+
+    _usb_talk_message_write(": ", 2);
+
+    _usb_talk.tx_key = true;
+}
+
+void usb_talk_message_key_node_id(uint64_t *device_address)
+{
+    usb_talk_message_node_id(device_address);
+
+    _usb_talk_message_write(": ", 2);
+
+    _usb_talk.tx_key = true;
+}
+
+void usb_talk_message_string(const char *value)
+{
+    if (value == NULL)
+    {
+        usb_talk_message_null();
+
+        return;
+    }
+
+    _usb_talk_message_separator();
+
+    _usb_talk_message_string(value);
+}
+
+void usb_talk_message_node_id(uint64_t *device_address)
+{
+    _usb_talk_message_separator();
+
+    char *p = _usb_talk_message_reserve(USB_TALK_NUMBER_MAX_LENGTH);
+
+    *p++ = '"';
+
+    p += _usb_talk_node_id_to_str(p, *device_address);
+
+    *p++ = '"';
+
+    _usb_talk.tx_length = p - _usb_talk.tx_buffer;
+}
+
+void usb_talk_message_int(int32_t value)
+{
+    _usb_talk_message_separator();
+
+    char *p = _usb_talk_message_reserve(USB_TALK_NUMBER_MAX_LENGTH);
+
+    if (value < 0)
+    {
+        *p++ = '-';
+    }
+
+    p += _usb_talk_uint_to_str(p, value < 0 ? -(uint32_t) value : (uint32_t) value);
+
+    _usb_talk.tx_length = p - _usb_talk.tx_buffer;
+}
+
+void usb_talk_message_uint(uint32_t value)
+{
+    _usb_talk_message_separator();
+
+    char *p = _usb_talk_message_reserve(USB_TALK_NUMBER_MAX_LENGTH);
+
+    _usb_talk.tx_length += _usb_talk_uint_to_str(p, value);
+}
+
+void usb_talk_message_uint64(uint64_t value)
+{
+    _usb_talk_message_separator();
+
+    char *p = _usb_talk_message_reserve(USB_TALK_NUMBER_MAX_LENGTH);
+
+    _usb_talk.tx_length += _usb_talk_uint64_to_str(p, value);
+}
+
+void usb_talk_message_float(float *value, int decimals)
+{
+    if ((value == NULL) || isnan(*value) || isinf(*value))
+    {
+        usb_talk_message_null();
+
+        return;
+    }
+
+    _usb_talk_message_separator();
+
+    char *p = _usb_talk_message_reserve(USB_TALK_NUMBER_MAX_LENGTH);
 
-        _usb_talk.tx_length += 4;
+    _usb_talk.tx_length += _usb_talk_float_to_str(p, *value, decimals);
+}
+
+void usb_talk_message_bool(bool value)
+{
+    _usb_talk_message_separator();
+
+    if (value)
+    {
+        _usb_talk_message_write("true", 4);
     }
     else
     {
-        _usb_talk.tx_length += snprintf(_usb_talk.tx_buffer + _usb_talk.tx_length, sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length, format, *value);
+        _usb_talk_message_write("false", 5);
     }
 }
 
+void usb_talk_message_null(void)
+{
+    _usb_talk_message_separator();
+
+    _usb_talk_message_write("null", 4);
+}
+
 void usb_talk_message_send(void)
 {
-    strcpy(_usb_talk.tx_buffer + _usb_talk.tx_length, "]\n");
+    // The line end must not be split, the envelope is inserted in front of it
+    _usb_talk_message_reserve(2);
 
-    _usb_talk.tx_length += 2;
+    _usb_talk_message_write("]\n", 2);
 
-#if TALK_OVER_CDC
-    twr_usb_cdc_write(_usb_talk.tx_buffer, _usb_talk.tx_length);
-#else
-    twr_uart_async_write(TWR_UART_UART2, _usb_talk.tx_buffer, _usb_talk.tx_length);
-#endif
+    _usb_talk_message_flush();
 }
 
 void usb_talk_publish_null(uint64_t *device_address, const char *subtopics)
 {
-    usb_talk_send_format("[\"%012llx/%s\", null]\n", *device_address, subtopics);
+    retained_null(device_address, subtopics);
+
+    usb_talk_message_start_id(device_address, "%s", subtopics);
+
+    usb_talk_message_null();
+
+    usb_talk_message_send();
 }
 
 void usb_talk_publish_bool(uint64_t *device_address, const char *subtopics, bool *value)
@@ -234,7 +647,13 @@ void usb_talk_publish_bool(uint64_t *device_address, const char *subtopics, bool
         return;
     }
 
-    usb_talk_send_format("[\"%012llx/%s\", %s]\n", *device_address, subtopics, *value ? "true" : "false");
+    retained_bool(device_address, subtopics, *value);
+
+    usb_talk_message_start_id(device_address, "%s", subtopics);
+
+    usb_talk_message_bool(*value);
+
+    usb_talk_message_send();
 }
 
 void usb_talk_publish_int(uint64_t *device_address, const char *subtopics, int *value)
@@ -246,10 +665,16 @@ void usb_talk_publish_int(uint64_t *device_address, const char *subtopics, int *
         return;
     }
 
-    usb_talk_send_format("[\"%012llx/%s\", %d]\n", *device_address, subtopics, *value);
+    retained_int(device_address, subtopics, *value);
+
+    usb_talk_message_start_id(device_address, "%s", subtopics);
+
+    usb_talk_message_int(*value);
+
+    usb_talk_message_send();
 }
 
-void usb_talk_publish_float(uint64_t *device_address, const char *subtopics, float *value)
+void usb_talk_publish_uint32(uint64_t *device_address, const char *subtopics, uint32_t *value)
 {
     if (value == NULL)
     {
@@ -258,42 +683,50 @@ void usb_talk_publish_float(uint64_t *device_address, const char *subtopics, flo
         return;
     }
 
-    usb_talk_send_format("[\"%012llx/%s\", %0.2f]\n", *device_address, subtopics, *value);
+    retained_uint(device_address, subtopics, *value);
+
+    usb_talk_message_start_id(device_address, "%s", subtopics);
+
+    usb_talk_message_uint(*value);
+
+    usb_talk_message_send();
+}
+
+void usb_talk_publish_float(uint64_t *device_address, const char *subtopics, float *value)
+{
+    _usb_talk_publish_float(device_address, subtopics, value, precision_class_find(subtopics));
 }
 
 void usb_talk_publish_complex_bool(uint64_t *device_address, const char *subtopic, const char *number, const char *name, bool *state)
 {
-    snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                "[\"%012llx/%s/%s/%s\", %s]\n",
-                *device_address, subtopic, number, name, *state ? "true" : "false");
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
+
+    snprintf(topic, sizeof(topic), "%s/%s/%s", subtopic, number, name);
 
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    usb_talk_publish_bool(device_address, topic, state);
 }
 
 void usb_talk_publish_event_count(uint64_t *device_address, const char *name, uint16_t *event_count)
 {
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
+
+    snprintf(topic, sizeof(topic), "%s/event-count", name);
+
     if (event_count == NULL)
     {
-        snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                 "[\"%012llx/%s/event-count\", null]\n",
-                 *device_address, name);
+        usb_talk_publish_null(device_address, topic);
     }
     else
     {
-        snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                 "[\"%012llx/%s/event-count\", %" PRIu16 "]\n",
-                 *device_address, name, *event_count);
+        uint32_t value = *event_count;
+
+        usb_talk_publish_uint32(device_address, topic, &value);
     }
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
 }
 
 void usb_talk_publish_led(uint64_t *device_address, bool *state)
 {
-    snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                "[\"%012llx/led/-/state\", %s]\n",
-                *device_address, *state ? "true" : "false");
-
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    usb_talk_publish_bool(device_address, "led/-/state", state);
 }
 
 void usb_talk_publish_temperature(uint64_t *device_address, uint8_t channel, float *celsius)
@@ -314,157 +747,219 @@ void usb_talk_publish_temperature(uint64_t *device_address, uint8_t channel, flo
         return;
     }
 
-    usb_talk_message_start_id(device_address, "thermometer/%d:%d/temperature", ((channel & 0x80) >> 7), (channel & ~0x80));
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
 
-    usb_talk_message_append_float("%.2f", celsius);
+    snprintf(topic, sizeof(topic), "thermometer/%d:%d/temperature", ((channel & 0x80) >> 7), (channel & ~0x80));
 
-    usb_talk_message_send();
+    _usb_talk_publish_float(device_address, topic, celsius, PRECISION_CLASS_TEMPERATURE);
 }
 
 void usb_talk_publish_humidity(uint64_t *device_address, uint8_t channel, float *relative_humidity)
 {
-    usb_talk_message_start_id(device_address, "hygrometer/%d:%d/relative-humidity", ((channel & 0x80) >> 7), (channel & ~0x80));
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
 
-    usb_talk_message_append_float("%.1f", relative_humidity);
+    snprintf(topic, sizeof(topic), "hygrometer/%d:%d/relative-humidity", ((channel & 0x80) >> 7), (channel & ~0x80));
 
-    usb_talk_message_send();
+    _usb_talk_publish_float(device_address, topic, relative_humidity, PRECISION_CLASS_HUMIDITY);
 }
 
 void usb_talk_publish_lux_meter(uint64_t *device_address, uint8_t channel, float *illuminance)
 {
-    usb_talk_message_start_id(device_address, "lux-meter/%d:%d/illuminance", ((channel & 0x80) >> 7), (channel & ~0x80));
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
 
-    usb_talk_message_append_float("%.1f", illuminance);
+    snprintf(topic, sizeof(topic), "lux-meter/%d:%d/illuminance", ((channel & 0x80) >> 7), (channel & ~0x80));
 
-    usb_talk_message_send();
+    _usb_talk_publish_float(device_address, topic, illuminance, PRECISION_CLASS_ILLUMINANCE);
 }
 
 void usb_talk_publish_barometer(uint64_t *device_address, uint8_t channel, float *pressure, float *altitude)
 {
-    usb_talk_message_start_id(device_address, "barometer/%d:%d/pressure", ((channel & 0x80) >> 7), (channel & ~0x80));
-
-    usb_talk_message_append_float("%.2f", pressure);
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
 
-    usb_talk_message_send();
+    snprintf(topic, sizeof(topic), "barometer/%d:%d/pressure", ((channel & 0x80) >> 7), (channel & ~0x80));
 
-    usb_talk_message_start_id(device_address, "barometer/%d:%d/altitude", ((channel & 0x80) >> 7), (channel & ~0x80));
+    _usb_talk_publish_float(device_address, topic, pressure, PRECISION_CLASS_PRESSURE);
 
-    usb_talk_message_append_float("%.2f", altitude);
+    snprintf(topic, sizeof(topic), "barometer/%d:%d/altitude", ((channel & 0x80) >> 7), (channel & ~0x80));
 
-    usb_talk_message_send();
+    _usb_talk_publish_float(device_address, topic, altitude, PRECISION_CLASS_ALTITUDE);
 }
 
 void usb_talk_publish_co2(uint64_t *device_address, float *concentration)
 {
-    usb_talk_message_start_id(device_address, "co2-meter/-/concentration");
-
-    usb_talk_message_append_float("%.0f", concentration);
+    _usb_talk_publish_float(device_address, "co2-meter/-/concentration", concentration, PRECISION_CLASS_CONCENTRATION);
+}
 
-    usb_talk_message_send();
+void usb_talk_publish_battery(uint64_t *device_address, float *voltage)
+{
+    _usb_talk_publish_float(device_address, "battery/-/voltage", voltage, PRECISION_CLASS_VOLTAGE);
 }
 
 void usb_talk_publish_relay(uint64_t *device_address, bool *state)
 {
-    snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                "[\"%012llx/relay/-/state\", %s]\n",
-                *device_address, *state ? "true" : "false");
-
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    usb_talk_publish_bool(device_address, "relay/-/state", state);
 }
 
 void usb_talk_publish_module_relay(uint64_t *device_address, uint8_t *number, twr_module_relay_state_t *state)
 {
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
+
+    snprintf(topic, sizeof(topic), "relay/0:%d/state", *number);
+
     if (*state == TWR_MODULE_RELAY_STATE_UNKNOWN)
     {
-        snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                    "[\"%012llx/relay/0:%d/state\", null]\n",
-                    *device_address, *number);
+        usb_talk_publish_null(device_address, topic);
     }
     else
     {
-        snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                    "[\"%012llx/relay/0:%d/state\", %s]\n",
-                    *device_address, *number, *state == TWR_MODULE_RELAY_STATE_TRUE ? "true" : "false");
-    }
+        bool value = *state == TWR_MODULE_RELAY_STATE_TRUE;
 
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+        usb_talk_publish_bool(device_address, topic, &value);
+    }
 }
 
 void usb_talk_publish_encoder(uint64_t *device_address, int *increment)
 {
-    snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-             "[\"%012llx/encoder/-/increment\", %d]\n",
-             *device_address, *increment);
+    usb_talk_message_start_id(device_address, "encoder/-/increment");
+
+    usb_talk_message_int(*increment);
 
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    usb_talk_message_send();
 }
 
 void usb_talk_publish_flood_detector(uint64_t *device_address, const char *number, bool *state)
 {
-    snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-             "[\"%012llx/flood-detector/%c/alarm\", %s]\n",
-             *device_address, *number, *state ? "true" : "false");
+    char topic[USB_TALK_TOPIC_MAX_LENGTH];
 
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    snprintf(topic, sizeof(topic), "flood-detector/%c/alarm", *number);
+
+    usb_talk_publish_bool(device_address, topic, state);
 }
 
 void usb_talk_publish_accelerometer_acceleration(uint64_t *device_address, float *x_axis, float *y_axis, float *z_axis)
 {
+    retained_vector(device_address, "accelerometer/-/acceleration", x_axis, y_axis, z_axis);
+
     usb_talk_message_start_id(device_address, "accelerometer/-/acceleration");
 
-    if (x_axis == NULL)
-    {
-        usb_talk_message_append("[null");
-    }
-    else
-    {
-        usb_talk_message_append("[%.6f", *x_axis);
-    }
+    usb_talk_message_array_begin();
 
-    if (y_axis == NULL)
-    {
-        usb_talk_message_append(", null");
-    }
-    else
-    {
-        usb_talk_message_append(", %.6f", *y_axis);
-    }
+    usb_talk_message_float(x_axis, precision_decimals(PRECISION_CLASS_ACCELERATION, x_axis));
 
-    if (z_axis == NULL)
-    {
-        usb_talk_message_append(", null]");
-    }
-    else
-    {
-        usb_talk_message_append(", %.6f]", *z_axis);
-    }
+    usb_talk_message_float(y_axis, precision_decimals(PRECISION_CLASS_ACCELERATION, y_axis));
+
+    usb_talk_message_float(z_axis, precision_decimals(PRECISION_CLASS_ACCELERATION, z_axis));
+
+    usb_talk_message_array_end();
 
     usb_talk_message_send();
 }
 
 void usb_talk_publish_buffer(uint64_t *device_address, void *buffer, size_t length)
 {
-    usb_talk_message_start_id(device_address, "buffer/-/data");
+    static const char hex[] = "0123456789abcdef";
 
-    _usb_talk.tx_buffer[_usb_talk.tx_length++] = '[';
+    const uint8_t *data = (const uint8_t *) buffer;
 
-    for (size_t i = 0; i < length; i++)
+    char *p;
+
+    size_t i;
+
+    switch (_usb_talk.buffer_format)
     {
-        usb_talk_message_append("%d, ", ((uint8_t *) buffer)[i]);
-    }
+        case USB_TALK_BUFFER_FORMAT_BASE64:
+        {
+            usb_talk_message_start_id(device_address, "buffer/-/base64");
+
+            _usb_talk_message_separator();
+
+            _usb_talk_message_write("\"", 1);
+
+            while (length > 0)
+            {
+                // Whole 3 byte groups only, except for the last chunk
+                size_t chunk = length > 96 ? 96 : length;
+
+                size_t encode_length = twr_base64_calculate_encode_length(chunk) + 1;
+
+                p = _usb_talk_message_reserve(encode_length);
+
+                if (!twr_base64_encode(p, &encode_length, data, chunk))
+                {
+                    break;
+                }
+
+                _usb_talk.tx_length += encode_length;
+
+                data += chunk;
+
+                length -= chunk;
+            }
+
+            _usb_talk_message_write("\"", 1);
+
+            break;
+        }
+        case USB_TALK_BUFFER_FORMAT_HEX:
+        {
+            usb_talk_message_start_id(device_address, "buffer/-/hex");
+
+            _usb_talk_message_separator();
+
+            _usb_talk_message_write("\"", 1);
+
+            for (i = 0; i < length; i++)
+            {
+                p = _usb_talk_message_reserve(2);
+
+                p[0] = hex[data[i] >> 4];
+                p[1] = hex[data[i] & 0x0f];
+
+                _usb_talk.tx_length += 2;
+            }
 
-    _usb_talk.tx_length--;
+            _usb_talk_message_write("\"", 1);
 
-    _usb_talk.tx_buffer[_usb_talk.tx_length - 1] = ']';
+            break;
+        }
+        case USB_TALK_BUFFER_FORMAT_ARRAY:
+        default:
+        {
+            usb_talk_message_start_id(device_address, "buffer/-/data");
+
+            usb_talk_message_array_begin();
+
+            for (i = 0; i < length; i++)
+            {
+                // Worst case "255, " is 5 characters per byte
+                p = _usb_talk_message_reserve(5);
+
+                if (i != 0)
+                {
+                    *p++ = ',';
+                    *p++ = ' ';
+                }
+
+                p += _usb_talk_uint_to_str(p, data[i]);
+
+                _usb_talk.tx_length = p - _usb_talk.tx_buffer;
+            }
+
+            usb_talk_message_array_end();
+
+            break;
+        }
+    }
 
     usb_talk_message_send();
 }
 
 void usb_talk_publish_nodes(uint64_t *peer_devices_address, int lenght)
 {
-    int offset = snprintf(_usb_talk.tx_buffer, sizeof(_usb_talk.tx_buffer),
-                 "[\"/nodes\", [" );
-    bool empty = true;
+    usb_talk_message_start("/nodes");
+
+    usb_talk_message_array_begin();
+
     for (int i = 0; i < lenght; i++)
     {
         if (peer_devices_address[i] == 0)
@@ -472,16 +967,12 @@ void usb_talk_publish_nodes(uint64_t *peer_devices_address, int lenght)
             continue;
         }
 
-        offset += snprintf(_usb_talk.tx_buffer + offset, sizeof(_usb_talk.tx_buffer) - offset,
-                empty ? "\"%012llx\"" : ",\"%012llx\"",
-                peer_devices_address[i]);
-
-        empty = false;
+        usb_talk_message_node_id(&peer_devices_address[i]);
     }
 
-    strncpy(_usb_talk.tx_buffer + offset, "]]\n", sizeof(_usb_talk.tx_buffer) - offset);
+    usb_talk_message_array_end();
 
-    usb_talk_send_string((const char *) _usb_talk.tx_buffer);
+    usb_talk_message_send();
 }
 
 #if TALK_OVER_CDC
@@ -489,6 +980,8 @@ static void _usb_talk_cdc_read_task(void *param)
 {
     (void) param;
 
+    stats_mark_t start = stats_mark();
+
     while (true)
     {
         static uint8_t buffer[16];
@@ -506,6 +999,8 @@ static void _usb_talk_cdc_read_task(void *param)
         }
     }
 
+    stats_task(STATS_TASK_USB_TALK, start);
+
     twr_scheduler_plan_current_now();
 }
 #else
@@ -517,6 +1012,15 @@ static void _usb_talk_uart_event_handler(twr_uart_channel_t channel, twr_uart_ev
 
     if (event == TWR_UART_EVENT_ASYNC_READ_DATA)
     {
+        stats_mark_t start = stats_mark();
+
+        size_t fifo_length = _usb_talk_fifo_length(&_usb_talk.read_fifo);
+
+        if (fifo_length > _usb_talk.buffers.read_fifo_peak)
+        {
+            _usb_talk.buffers.read_fifo_peak = fifo_length;
+        }
+
         while (true)
         {
             static uint8_t buffer[16];
@@ -533,6 +1037,19 @@ static void _usb_talk_uart_event_handler(twr_uart_channel_t channel, twr_uart_ev
                 _usb_talk_process_character((char) buffer[i]);
             }
         }
+
+        stats_task(STATS_TASK_USB_TALK, start);
+    }
+    else if (event == TWR_UART_EVENT_ASYNC_WRITE_DONE)
+    {
+        twr_tick_t now = twr_tick_get();
+
+        for (int i = 0; i < _usb_talk.tx_pending_length; i++)
+        {
+            stats_latency(_usb_talk.tx_pending[i].event, now - _usb_talk.tx_pending[i].tick);
+        }
+
+        _usb_talk.tx_pending_length = 0;
     }
 }
 #endif
@@ -561,7 +1078,16 @@ static void _usb_talk_process_character(char character)
 {
     if (character == '\n')
     {
-        if (!_usb_talk.rx_error && _usb_talk.rx_length > 0)
+        if (_usb_talk.rx_length > _usb_talk.buffers.rx_peak)
+        {
+            _usb_talk.buffers.rx_peak = _usb_talk.rx_length;
+        }
+
+        if (_usb_talk.rx_error)
+        {
+            _usb_talk.buffers.rx_dropped++;
+        }
+        else if (_usb_talk.rx_length > 0)
         {
             _usb_talk_process_message(_usb_talk.rx_buffer, _usb_talk.rx_length);
         }
@@ -617,17 +1143,32 @@ static void _usb_talk_process_message(char *message, size_t length)
 
     if ((topic[0] != '$') && (topic[0] != '/'))
     {
-        if (topic_length < 14)
+        char *slash = memchr(topic, '/', topic_length);
+
+        if (slash == NULL)
+        {
+            return;
+        }
+
+        size_t node_length = slash - topic;
+
+        if (node_length + 1 >= topic_length)
         {
             return;
         }
-        if(topic[12] != '/')
+
+        // Twelve hex digits are a node ID, anything else is looked up as an alias name
+        if ((node_length == 12) && (strspn(topic, "0123456789abcdefABCDEF") >= 12))
+        {
+            sscanf(topic, "%012llx/", &device_address);
+        }
+        else if (!eeprom_alias_resolve(topic, node_length, &device_address))
         {
             return;
         }
-        sscanf(topic, "%012llx/", &device_address);
-        topic += 13;
-        topic_length -= 13;
+
+        topic += node_length + 1;
+        topic_length -= node_length + 1;
     }
 
     for (int i = 0; i < _usb_talk.subscribes_length; i++)
@@ -639,7 +1180,12 @@ static void _usb_talk_process_message(char *message, size_t length)
                     token_count - USB_TALK_TOKEN_PAYLOAD,
                     tokens + USB_TALK_TOKEN_PAYLOAD
             };
+
+            stats_stack_probe(NULL);
+
             _usb_talk.subscribes[i].callback(&device_address, &payload, (usb_talk_subscribe_t *) &_usb_talk.subscribes[i]);
+
+            stats_stack_probe(_usb_talk.subscribes[i].topic);
         }
     }
 
@@ -652,7 +1198,12 @@ static void _usb_talk_process_message(char *message, size_t length)
                     token_count - USB_TALK_TOKEN_PAYLOAD,
                     tokens + USB_TALK_TOKEN_PAYLOAD
             };
+
+            stats_stack_probe(NULL);
+
             _usb_talk.subs[i].callback(&device_address, &payload, (usb_talk_subscribe_t *) &_usb_talk.subs[i]);
+
+            stats_stack_probe(_usb_talk.subs[i].topic);
         }
     }
 
@@ -861,6 +1412,23 @@ bool usb_talk_payload_get_key_int(usb_talk_payload_t *payload, const char *key,
     return false;
 }
 
+bool usb_talk_payload_get_uint64(usb_talk_payload_t *payload, uint64_t *value)
+{
+    return _usb_talk_token_get_uint64(payload->buffer, &payload->tokens[0], value);
+}
+
+bool usb_talk_payload_get_key_uint64(usb_talk_payload_t *payload, const char *key, uint64_t *value)
+{
+    for (int i = 1; i + 1 < payload->token_count; i += 2)
+    {
+        if (usb_talk_is_string_token_equal(payload->buffer, &payload->tokens[i], key))
+        {
+            return _usb_talk_token_get_uint64(payload->buffer, &payload->tokens[i + 1], value);
+        }
+    }
+    return false;
+}
+
 bool usb_talk_payload_get_float(usb_talk_payload_t *payload, float *value)
 {
     return _usb_talk_token_get_float(payload->buffer, &payload->tokens[0], value);
@@ -953,6 +1521,50 @@ bool usb_talk_payload_get_key_color(usb_talk_payload_t *payload, const char *key
     return false;
 }
 
+int usb_talk_payload_get_object_size(usb_talk_payload_t *payload)
+{
+    if ((payload->token_count < 1) || (payload->tokens[0].type != JSMN_OBJECT))
+    {
+        return -1;
+    }
+
+    return payload->tokens[0].size;
+}
+
+bool usb_talk_payload_get_pair_node_id(usb_talk_payload_t *payload, int pair, uint64_t *key, char *buffer, size_t *length)
+{
+    // Flat object of string values, pair n is at tokens 2n + 1 and 2n + 2
+    int i = (2 * pair) + 1;
+
+    if (i + 1 >= payload->token_count)
+    {
+        return false;
+    }
+
+    if (!_usb_talk_payload_get_node_id(payload->buffer, &payload->tokens[i], key))
+    {
+        return false;
+    }
+
+    if (payload->tokens[i + 1].type != JSMN_STRING)
+    {
+        return false;
+    }
+
+    uint32_t token_length = payload->tokens[i + 1].end - payload->tokens[i + 1].start;
+
+    if (token_length > *length - 1)
+    {
+        return false;
+    }
+
+    strncpy(buffer, &payload->buffer[payload->tokens[i + 1].start], token_length);
+    *length = token_length;
+    buffer[token_length] = 0;
+
+    return true;
+}
+
 bool usb_talk_payload_get_compound(usb_talk_payload_t *payload, uint8_t *compound, size_t *length, int *count_sum)
 {
     if (payload->tokens[0].type != JSMN_ARRAY)
@@ -1053,6 +1665,38 @@ static bool _usb_talk_token_get_int(const char *buffer, jsmntok_t *token, int *v
     return true;
 }
 
+static bool _usb_talk_token_get_uint64(const char *buffer, jsmntok_t *token, uint64_t *value)
+{
+    if (token->type != JSMN_PRIMITIVE)
+    {
+        return false;
+    }
+
+    int length = token->end - token->start;
+
+    // Plain digits only, the int parser is limited to 32 bits
+    if ((length < 1) || (length > 20))
+    {
+        return false;
+    }
+
+    uint64_t result = 0;
+
+    for (int i = token->start; i < token->end; i++)
+    {
+        if ((buffer[i] < '0') || (buffer[i] > '9'))
+        {
+            return false;
+        }
+
+        result = result * 10 + (buffer[i] - '0');
+    }
+
+    *value = result;
+
+    return true;
+}
+
 static bool _usb_talk_token_get_float(const char *buffer, jsmntok_t *token, float *value)
 {
     if (token->type != JSMN_PRIMITIVE)
@@ -1155,3 +1799,485 @@ static bool _usb_talk_payload_get_color(const char *buffer, jsmntok_t *token, ui
 
     return true;
 }
+
+static void _usb_talk_write(const char *buffer, size_t length)
+{
+    bool line_end = (length >= 2) && (buffer[length - 2] == ']') && (buffer[length - 1] == '\n');
+
+    if (line_end && (_usb_talk.envelope || _usb_talk.timestamp))
+    {
+        _usb_talk_write_envelope(buffer, length);
+    }
+    else
+    {
+        // Part of a long line, or a line that was cut and gets no envelope
+        if ((length > 0) && (buffer[length - 1] == '\n'))
+        {
+            _usb_talk.tx_crc = CRC16_INIT;
+        }
+        else if (_usb_talk.envelope)
+        {
+            _usb_talk.tx_crc = crc16(_usb_talk.tx_crc, buffer, length);
+        }
+
+        _usb_talk_transport(buffer, length);
+    }
+
+    if (line_end && _usb_talk_event_is_valid())
+    {
+        stats_task(STATS_TASK_RADIO, _usb_talk.event_mark);
+
+#if TALK_OVER_CDC
+        // The line is in the CDC driver buffer
+        stats_latency(_usb_talk.event, twr_tick_get() - _usb_talk.event_tick);
+#else
+        // The line is complete once the UART write FIFO drains
+        if (_usb_talk.tx_pending_length < USB_TALK_TX_PENDING_LENGTH)
+        {
+            _usb_talk.tx_pending[_usb_talk.tx_pending_length].event = _usb_talk.event;
+            _usb_talk.tx_pending[_usb_talk.tx_pending_length].tick = _usb_talk.event_tick;
+
+            _usb_talk.tx_pending_length++;
+        }
+#endif
+
+        // A radio handler sends at most one line, later ones are not its own
+        _usb_talk.event = STATS_EVENT_NONE;
+    }
+}
+
+static void _usb_talk_write_envelope(const char *buffer, size_t length)
+{
+    size_t line_length = length - 2;
+
+    _usb_talk_transport(buffer, line_length);
+
+    char envelope[64];
+
+    size_t envelope_length = 3;
+
+    memcpy(envelope, ", {", 3);
+
+    if (_usb_talk.timestamp)
+    {
+        memcpy(envelope + envelope_length, "\"t\": ", 5);
+
+        envelope_length += 5;
+
+        envelope_length += _usb_talk_uint64_to_str(envelope + envelope_length, timesync_get(usb_talk_get_event_tick()));
+
+        if (_usb_talk.envelope)
+        {
+            memcpy(envelope + envelope_length, ", ", 2);
+
+            envelope_length += 2;
+        }
+    }
+
+    if (_usb_talk.envelope)
+    {
+        envelope_length += snprintf(envelope + envelope_length, sizeof(envelope) - envelope_length, "\"seq\": %lu, ", (unsigned long) _usb_talk.tx_sequence);
+
+        // CRC covers the line up to the "crc" key, without the closing bracket of the line
+        uint16_t crc = crc16(_usb_talk.tx_crc, buffer, line_length);
+
+        crc = crc16(crc, envelope, envelope_length);
+
+        envelope_length += snprintf(envelope + envelope_length, sizeof(envelope) - envelope_length, "\"crc\": \"%04x\"", crc);
+
+        // A gap in the sequence tells the host a line was lost
+        _usb_talk.tx_sequence++;
+    }
+
+    memcpy(envelope + envelope_length, "}]\n", 3);
+
+    envelope_length += 3;
+
+    _usb_talk_transport(envelope, envelope_length);
+
+    _usb_talk.tx_crc = CRC16_INIT;
+}
+
+#if !TALK_OVER_CDC
+static size_t _usb_talk_fifo_length(twr_fifo_t *fifo)
+{
+    size_t head = fifo->head;
+    size_t tail = fifo->tail;
+
+    return head >= tail ? head - tail : fifo->size - tail + head;
+}
+#endif
+
+static bool _usb_talk_event_is_valid(void)
+{
+    // The event holds for the first line sent within the same scheduler pass, one filtered out ends with the pass
+    return (_usb_talk.event != STATS_EVENT_NONE) && (_usb_talk.event_spin == twr_scheduler_get_spin_tick());
+}
+
+static void _usb_talk_transport(const char *buffer, size_t length)
+{
+#if TALK_OVER_CDC
+    if (!twr_usb_cdc_write(buffer, length))
+    {
+        _usb_talk.buffers.tx_overflow++;
+
+        _usb_talk.buffers.tx_dropped += length;
+    }
+#else
+    size_t written = twr_uart_async_write(TWR_UART_UART2, buffer, length);
+
+    if (written < length)
+    {
+        _usb_talk.buffers.tx_overflow++;
+
+        _usb_talk.buffers.tx_dropped += length - written;
+    }
+
+    // Only the UART interrupt drains the FIFO, so the peak is right after a write
+    size_t fifo_length = _usb_talk_fifo_length(&_usb_talk.write_fifo);
+
+    if (fifo_length > _usb_talk.buffers.write_fifo_peak)
+    {
+        _usb_talk.buffers.write_fifo_peak = fifo_length;
+    }
+#endif
+}
+
+static void _usb_talk_message_begin(void)
+{
+    _usb_talk.tx_buffer[0] = '[';
+    _usb_talk.tx_buffer[1] = '"';
+
+    _usb_talk.tx_length = 2;
+
+    // The topic is the first value of the top level array
+    _usb_talk.tx_depth = 0;
+    _usb_talk.tx_first = 0;
+    _usb_talk.tx_key = false;
+}
+
+static void _usb_talk_message_topic(const char *topic, va_list ap)
+{
+    // Keep space for the closing quote and separator
+    size_t space = sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length - 3;
+
+    int length = vsnprintf(_usb_talk.tx_buffer + _usb_talk.tx_length, space, topic, ap);
+
+    if (length > 0)
+    {
+        if ((size_t) length >= space)
+        {
+            _usb_talk.buffers.tx_truncated++;
+        }
+
+        _usb_talk.tx_length += ((size_t) length < space) ? (size_t) length : space - 1;
+    }
+
+    _usb_talk_message_write("\"", 1);
+}
+
+static void _usb_talk_message_flush(void)
+{
+    if (_usb_talk.tx_length == 0)
+    {
+        return;
+    }
+
+    if (_usb_talk.tx_length > _usb_talk.buffers.tx_peak)
+    {
+        _usb_talk.buffers.tx_peak = _usb_talk.tx_length;
+    }
+
+    _usb_talk_write(_usb_talk.tx_buffer, _usb_talk.tx_length);
+
+    _usb_talk.tx_length = 0;
+}
+
+static char *_usb_talk_message_reserve(size_t length)
+{
+    if (_usb_talk.tx_length + length > sizeof(_usb_talk.tx_buffer))
+    {
+        // Long message, send what is formatted so far and continue the same line
+        _usb_talk_message_flush();
+
+        _usb_talk.buffers.tx_split++;
+    }
+
+    return _usb_talk.tx_buffer + _usb_talk.tx_length;
+}
+
+static void _usb_talk_message_write(const char *buffer, size_t length)
+{
+    while (length > 0)
+    {
+        size_t space = sizeof(_usb_talk.tx_buffer) - _usb_talk.tx_length;
+
+        if (space == 0)
+        {
+            _usb_talk_message_flush();
+
+            _usb_talk.buffers.tx_split++;
+
+            space = sizeof(_usb_talk.tx_buffer);
+        }
+
+        size_t chunk = length < space ? length : space;
+
+        memcpy(_usb_talk.tx_buffer + _usb_talk.tx_length, buffer, chunk);
+
+        _usb_talk.tx_length += chunk;
+
+        buffer += chunk;
+
+        length -= chunk;
+    }
+}
+
+static void _usb_talk_message_separator(void)
+{
+    uint8_t bit = 1 << _usb_talk.tx_depth;
+
+    if (_usb_talk.tx_key)
+    {
+        _usb_talk.tx_key = false;
+    }
+    else if (_usb_talk.tx_first & bit)
+    {
+        _usb_talk.tx_first &= ~bit;
+    }
+    else
+    {
+        _usb_talk_message_write(", ", 2);
+    }
+}
+
+static void _usb_talk_message_container_begin(char character)
+{
+    _usb_talk_message_separator();
+
+    _usb_talk_message_write(&character, 1);
+
+    if (_usb_talk.tx_depth < USB_TALK_MESSAGE_MAX_DEPTH - 1)
+    {
+        _usb_talk.tx_depth++;
+    }
+
+    _usb_talk.tx_first |= 1 << _usb_talk.tx_depth;
+}
+
+static void _usb_talk_message_container_end(char character)
+{
+    _usb_talk_message_write(&character, 1);
+
+    if (_usb_talk.tx_depth > 0)
+    {
+        _usb_talk.tx_depth--;
+    }
+}
+
+static void _usb_talk_message_string(const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    const char *start = str;
+
+    char escape[6];
+
+    _usb_talk_message_write("\"", 1);
+
+    for (; *str != '\0'; str++)
+    {
+        uint8_t character = (uint8_t) *str;
+
+        if ((character >= 0x20) && (character != '"') && (character != '\\'))
+        {
+            continue;
+        }
+
+        _usb_talk_message_write(start, str - start);
+
+        start = str + 1;
+
+        escape[0] = '\\';
+
+        switch (character)
+        {
+            case '"':
+            case '\\':
+            {
+                escape[1] = character;
+                _usb_talk_message_write(escape, 2);
+                break;
+            }
+            case '\n':
+            {
+                escape[1] = 'n';
+                _usb_talk_message_write(escape, 2);
+                break;
+            }
+            case '\r':
+            {
+                escape[1] = 'r';
+                _usb_talk_message_write(escape, 2);
+                break;
+            }
+            case '\t':
+            {
+                escape[1] = 't';
+                _usb_talk_message_write(escape, 2);
+                break;
+            }
+            default:
+            {
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[character >> 4];
+                escape[5] = hex[character & 0x0f];
+                _usb_talk_message_write(escape, 6);
+                break;
+            }
+        }
+    }
+
+    _usb_talk_message_write(start, str - start);
+
+    _usb_talk_message_write("\"", 1);
+}
+
+static size_t _usb_talk_uint_to_str(char *str, uint32_t value)
+{
+    char tmp[10];
+    size_t length = 0;
+
+    do
+    {
+        tmp[length++] = '0' + value % 10;
+
+        value /= 10;
+    }
+    while (value != 0);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        str[i] = tmp[length - 1 - i];
+    }
+
+    return length;
+}
+
+static size_t _usb_talk_uint64_to_str(char *str, uint64_t value)
+{
+    if (value <= UINT32_MAX)
+    {
+        return _usb_talk_uint_to_str(str, (uint32_t) value);
+    }
+
+    char tmp[20];
+    size_t length = 0;
+
+    while (value != 0)
+    {
+        tmp[length++] = '0' + value % 10;
+
+        value /= 10;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        str[i] = tmp[length - 1 - i];
+    }
+
+    return length;
+}
+
+static size_t _usb_talk_node_id_to_str(char *str, uint64_t value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    // Same as USB_TALK_DEVICE_ADDRESS, at least 12 digits
+    size_t length = 12;
+
+    while ((length < 16) && ((value >> (length * 4)) != 0))
+    {
+        length++;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        str[length - 1 - i] = hex[(value >> (i * 4)) & 0x0f];
+    }
+
+    return length;
+}
+
+static size_t _usb_talk_float_to_str(char *str, float value, int decimals)
+{
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+    if (decimals < 0)
+    {
+        decimals = 0;
+    }
+    else if (decimals > 6)
+    {
+        decimals = 6;
+    }
+
+    float absolute = value < 0 ? -value : value;
+
+    if (absolute >= 4e9f)
+    {
+        // Out of the fixed point range, exponent form keeps any float within the reserved length
+        int length = snprintf(str, USB_TALK_NUMBER_MAX_LENGTH, "%.*e", decimals, value);
+
+        return length < 0 ? 0 : (length < USB_TALK_NUMBER_MAX_LENGTH ? (size_t) length : USB_TALK_NUMBER_MAX_LENGTH - 1);
+    }
+
+    uint32_t integer = (uint32_t) absolute;
+
+    uint32_t fraction = (uint32_t) ((absolute - integer) * pow10[decimals] + 0.5f);
+
+    if (fraction >= pow10[decimals])
+    {
+        integer++;
+
+        fraction -= pow10[decimals];
+    }
+
+    char *p = str;
+
+    if ((value < 0) && ((integer != 0) || (fraction != 0)))
+    {
+        *p++ = '-';
+    }
+
+    p += _usb_talk_uint_to_str(p, integer);
+
+    if (decimals > 0)
+    {
+        *p++ = '.';
+
+        for (int i = decimals - 1; i >= 0; i--)
+        {
+            p[i] = '0' + fraction % 10;
+
+            fraction /= 10;
+        }
+
+        p += decimals;
+    }
+
+    return p - str;
+}
+
+static void _usb_talk_publish_float(uint64_t *device_address, const char *topic, float *value, precision_class_t precision_class)
+{
+    retained_float(device_address, topic, value);
+
+    usb_talk_message_start_id(device_address, "%s", topic);
+
+    usb_talk_message_float(value, precision_decimals(precision_class, value));
+
+    usb_talk_message_send();
+}
@@ -4,6 +4,8 @@
 #include <twr_common.h>
 #include <jsmn.h>
 #include <twr_module_relay.h>
+#include <twr_tick.h>
+#include <stats.h>
 
 #ifndef USB_TALK_SUB_LENGTH
 #define USB_TALK_SUB_LENGTH 32
@@ -11,9 +13,23 @@
 #ifndef USB_TALK_SUB_TOPIC_MAX_LENGTH
 #define USB_TALK_SUB_TOPIC_MAX_LENGTH 32
 #endif
+#ifndef USB_TALK_BUFFER_FORMAT
+#define USB_TALK_BUFFER_FORMAT USB_TALK_BUFFER_FORMAT_ARRAY
+#endif
 #define USB_TALK_INT_VALUE_NULL INT32_MIN
 #define USB_TALK_DEVICE_ADDRESS "%012llx"
 
+typedef enum
+{
+    // Legacy decimal array, topic "buffer/-/data"
+    USB_TALK_BUFFER_FORMAT_ARRAY = 0,
+    // Base64 string, topic "buffer/-/base64"
+    USB_TALK_BUFFER_FORMAT_BASE64 = 1,
+    // Hex string, topic "buffer/-/hex"
+    USB_TALK_BUFFER_FORMAT_HEX = 2
+
+} usb_talk_buffer_format_t;
+
 typedef struct
 {
     char *buffer;
@@ -39,16 +55,42 @@ void usb_talk_subscribes(const usb_talk_subscribe_t *subscribes, int length);
 bool usb_talk_add_sub(const char *topic, usb_talk_sub_callback_t callback, uint8_t number, void *param);
 void usb_talk_send_string(const char *buffer);
 void usb_talk_send_format(const char *format, ...);
+void usb_talk_set_buffer_format(usb_talk_buffer_format_t format);
+usb_talk_buffer_format_t usb_talk_get_buffer_format(void);
+void usb_talk_set_envelope(bool enable);
+bool usb_talk_get_envelope(void);
+void usb_talk_set_timestamp(bool enable);
+bool usb_talk_get_timestamp(void);
+void usb_talk_event_begin(stats_event_t event);
+void usb_talk_buffers_reset(void);
+void usb_talk_buffers_list(void);
+bool usb_talk_is_tx_ready(void);
+twr_tick_t usb_talk_get_event_tick(void);
 
 void usb_talk_message_start(const char *topic, ...);
 void usb_talk_message_start_id(uint64_t *device_address, const char *topic, ...);
 void usb_talk_message_append(const char *format, ...);
 void usb_talk_message_append_float(const char *format, float *value);
+void usb_talk_message_object_begin(void);
+void usb_talk_message_object_end(void);
+void usb_talk_message_array_begin(void);
+void usb_talk_message_array_end(void);
+void usb_talk_message_key(const char *key);
+void usb_talk_message_key_node_id(uint64_t *device_address);
+void usb_talk_message_string(const char *value);
+void usb_talk_message_node_id(uint64_t *device_address);
+void usb_talk_message_int(int32_t value);
+void usb_talk_message_uint(uint32_t value);
+void usb_talk_message_uint64(uint64_t value);
+void usb_talk_message_float(float *value, int decimals);
+void usb_talk_message_bool(bool value);
+void usb_talk_message_null(void);
 void usb_talk_message_send(void);
 
 void usb_talk_publish_null(uint64_t *device_address, const char *subtopics);
 void usb_talk_publish_bool(uint64_t *device_address, const char *subtopics, bool *value);
 void usb_talk_publish_int(uint64_t *device_address, const char *subtopics, int *value);
+void usb_talk_publish_uint32(uint64_t *device_address, const char *subtopics, uint32_t *value);
 void usb_talk_publish_float(uint64_t *device_address, const char *subtopics, float *value);
 
 void usb_talk_publish_complex_bool(uint64_t *device_address, const char *subtopic, const char *number, const char *name, bool *state);
@@ -59,6 +101,7 @@ void usb_talk_publish_humidity(uint64_t *device_address, uint8_t channel, float
 void usb_talk_publish_lux_meter(uint64_t *device_address, uint8_t channel, float *illuminance);
 void usb_talk_publish_barometer(uint64_t *device_address, uint8_t channel, float *pascal, float *altitude);
 void usb_talk_publish_co2(uint64_t *device_address, float *concentration);
+void usb_talk_publish_battery(uint64_t *device_address, float *voltage);
 void usb_talk_publish_relay(uint64_t *device_address, bool *state);
 void usb_talk_publish_module_relay(uint64_t *device_address, uint8_t *number, twr_module_relay_state_t *state);
 void usb_talk_publish_encoder(uint64_t *device_address, int *increment);
@@ -76,6 +119,8 @@ bool usb_talk_payload_get_enum(usb_talk_payload_t *payload, int *value, ...);
 bool usb_talk_payload_get_key_enum(usb_talk_payload_t *payload, const char *key, int *value, ...);
 bool usb_talk_payload_get_int(usb_talk_payload_t *payload, int *value);
 bool usb_talk_payload_get_key_int(usb_talk_payload_t *payload, const char *key, int *value);
+bool usb_talk_payload_get_uint64(usb_talk_payload_t *payload, uint64_t *value);
+bool usb_talk_payload_get_key_uint64(usb_talk_payload_t *payload, const char *key, uint64_t *value);
 bool usb_talk_payload_get_float(usb_talk_payload_t *payload, float *value);
 bool usb_talk_payload_get_key_float(usb_talk_payload_t *payload, const char *key, float *value);
 bool usb_talk_payload_get_string(usb_talk_payload_t *payload, char *buffer, size_t *length);
@@ -84,6 +129,8 @@ bool usb_talk_payload_get_node_id(usb_talk_payload_t *payload, uint64_t *value);
 bool usb_talk_payload_get_key_node_id(usb_talk_payload_t *payload, const char *key, uint64_t *value);
 bool usb_talk_payload_get_color(usb_talk_payload_t *payload, uint32_t *color);
 bool usb_talk_payload_get_key_color(usb_talk_payload_t *payload, const char *key, uint32_t *color);
+int usb_talk_payload_get_object_size(usb_talk_payload_t *payload);
+bool usb_talk_payload_get_pair_node_id(usb_talk_payload_t *payload, int pair, uint64_t *key, char *buffer, size_t *length);
 bool usb_talk_payload_get_compound(usb_talk_payload_t *payload, uint8_t *compound, size_t *length, int *count_sum);
 
 bool usb_talk_is_string_token_equal(const char *buffer, jsmntok_t *token, const char *string);